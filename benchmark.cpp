@@ -0,0 +1,286 @@
+#include "booking.h"
+#include <filesystem>
+
+atomic<size_t> allocationCount(0);
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    if (void* memory = malloc(max<size_t>(size, 1))) {
+        return memory;
+    }
+    throw bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+class BenchmarkFixture {
+public:
+    BenchmarkFixture(const string& name, size_t planeCount) : directory_(filesystem::temp_directory_path() / ("booking-benchmark-" + name)) {
+        filesystem::remove_all(directory_);
+        filesystem::create_directories(directory_);
+        const char* zoneNames[] = {"front", "center", "back"};
+        json planeData;
+        json& layout = planeData["layouts"]["bench-144"];
+        for (int zone = 0; zone < 3; zone++) {
+            layout[zoneNames[zone]] = {{"rows", {zone * 8 + 1, zone * 8 + 8}}, {"columns", "ABCDEF"}};
+        }
+        json flightData;
+        for (size_t i = 0; i < planeCount; i++) {
+            char planeId[24];
+            char time[24];
+            snprintf(planeId, sizeof(planeId), "B%03zu", i);
+            snprintf(time, sizeof(time), "%02zu:%02zu", i / 60 % 24, i % 60);
+            json& plane = planeData["planes"][planeId];
+            plane["layout"] = "bench-144";
+            for (int zone = 0; zone < 3; zone++) {
+                json seats = json::array();
+                for (int row = zone * 8 + 1; row <= zone * 8 + 8; row++) {
+                    for (char column = 'A'; column <= 'F'; column++) {
+                        seats.push_back(to_string(row) + column);
+                    }
+                }
+                plane[zoneNames[zone]] = {{"free_seats", seats}, {"price", 100 + zone * 10}};
+            }
+            flightData["Kyiv"]["Warsaw"][string(kWeekDays[i / 1440 % 7])][planeId] = time;
+            planeIds_.push_back(planeId);
+            times_.push_back(time);
+        }
+        FileHandler(path("planeData.json")).writeJsonData(planeData);
+        FileHandler(path("flightData.json")).writeJsonData(flightData);
+    }
+
+    ~BenchmarkFixture() {
+        filesystem::remove_all(directory_);
+    }
+
+    string path(const string& file) const {
+        return (directory_ / file).string();
+    }
+
+    const string& planeId(size_t i) const {
+        return planeIds_[i % planeIds_.size()];
+    }
+
+    const string& time(size_t i) const {
+        return times_[i % times_.size()];
+    }
+private:
+    filesystem::path directory_;
+    vector<string> planeIds_;
+    vector<string> times_;
+};
+
+struct BookingEngine {
+    BookingEngine(const BenchmarkFixture& fixture) : flightData(fixture.path("flightData.json")), planeData(fixture.path("planeData.json")), schedule(flightData), airplane(planeData), heatmap(schedule, airplane), history(schedule, airplane), ledger(fixture.path("bookingLedger.bin"), history.validBytes()), ticket(schedule, airplane, heatmap, ledger, history) {}
+
+    FileHandler flightData;
+    FileHandler planeData;
+    FlightSchedule schedule;
+    Airplane airplane;
+    AvailabilityHeatmap heatmap;
+    LedgerReplay history;
+    BookingLedger ledger;
+    Ticket ticket;
+};
+
+vector<size_t> threadCounts(size_t maxThreads) {
+    vector<size_t> counts;
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        counts.push_back(threads);
+    }
+    return counts;
+}
+
+template <typename Function>
+double runThreads(size_t threads, Function function) {
+    vector<thread> workers;
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(function, i);
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+template <typename Function>
+double measureSeconds(Function function) {
+    auto start = chrono::steady_clock::now();
+    function();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+template <typename Function>
+size_t countAllocations(Function function) {
+    size_t before = allocationCount.load(memory_order_relaxed);
+    function();
+    return allocationCount.load(memory_order_relaxed) - before;
+}
+
+class NullBuffer : public streambuf {
+protected:
+    int overflow(int symbol) override {
+        return symbol;
+    }
+
+    streamsize xsputn(const char*, streamsize count) override {
+        return count;
+    }
+};
+
+vector<string> makeSeatNames(size_t count) {
+    vector<string> seats;
+    seats.reserve(count);
+    mt19937 random(29);
+    for (size_t i = 0; i < count; i++) {
+        seats.push_back(to_string(1 + random() % 30) + char('A' + random() % 6));
+    }
+    return seats;
+}
+
+void benchmarkSeatParsing() {
+    const vector<string> seats = makeSeatNames(200000);
+    vector<string> legacy = seats;
+    double legacySeconds = measureSeconds([&] {
+        sort(legacy.begin(), legacy.end(), [](const string& seat1, const string& seat2) {
+            return stoi(seat1.substr(0, seat1.size() - 1)) < stoi(seat2.substr(0, seat2.size() - 1));
+        });
+    });
+    vector<string> parsedPerComparison = seats;
+    double parsedSeconds = measureSeconds([&] {
+        sort(parsedPerComparison.begin(), parsedPerComparison.end(), [](const string& seat1, const string& seat2) {
+            return parseSeat(seat1) < parseSeat(seat2);
+        });
+    });
+    vector<SeatCode> packed(seats.size());
+    double packedSeconds = measureSeconds([&] {
+        transform(seats.begin(), seats.end(), packed.begin(), [](const string& seat) {
+            return parseSeat(seat);
+        });
+        sort(packed.begin(), packed.end());
+    });
+    cout << "Seat sort, " << seats.size() << " codes:\n";
+    cout << "  stoi(substr) comparator: " << legacySeconds * 1000 << " ms\n";
+    cout << "  parseSeat comparator:    " << parsedSeconds * 1000 << " ms\n";
+    cout << "  parse once, sort codes:  " << packedSeconds * 1000 << " ms\n";
+}
+
+void benchmarkHotFlight() {
+    const size_t operationsPerThread = 200000;
+    const char* zones[] = {"front", "center", "back"};
+    cout << "Hot flight claim/release, one plane, " << operationsPerThread << " operations per thread:\n";
+    for (size_t threads : threadCounts(max<size_t>(thread::hardware_concurrency(), 8))) {
+        BenchmarkFixture fixture("hot-flight", 1);
+        BookingEngine engine(fixture);
+        atomic<size_t> claimed(0);
+        double seconds = runThreads(threads, [&](size_t worker) {
+            size_t local = 0;
+            for (size_t i = 0; i < operationsPerThread; i++) {
+                SeatReservation seat = engine.airplane.reserveBestSeat(fixture.planeId(0), zones[(worker + i) % 3], AnySeat);
+                if (seat.price != 0) {
+                    engine.airplane.releaseSeat(fixture.planeId(0), seat.zone, seat.seat);
+                    local++;
+                }
+            }
+            claimed += local;
+        });
+        cout << "  " << threads << " threads: " << static_cast<uint64_t>(claimed / seconds) << " claims/s" << endl;
+    }
+}
+
+void benchmarkScaling() {
+    const size_t maxThreads = 64;
+    const size_t operationsPerThread = 2000;
+    const char* zones[] = {"front", "center", "back"};
+    cout << "Book and refund, one plane per thread, " << operationsPerThread << " bookings per thread:\n";
+    for (size_t threads : threadCounts(maxThreads)) {
+        BenchmarkFixture fixture("scaling", maxThreads);
+        BookingEngine engine(fixture);
+        atomic<size_t> booked(0);
+        double seconds = runThreads(threads, [&](size_t worker) {
+            const string username = "passenger-" + to_string(worker);
+            size_t local = 0;
+            for (size_t i = 0; i < operationsPerThread; i++) {
+                string ticketId = engine.ticket.bookBestSeat(fixture.planeId(worker), fixture.time(worker), zones[i % 3], AnySeat, username);
+                if (engine.ticket.refund(ticketId).rfind("Confirmed", 0) == 0) {
+                    local++;
+                }
+            }
+            booked += local;
+        });
+        cout << "  " << threads << " threads: " << static_cast<uint64_t>(booked / seconds) << " bookings/s" << endl;
+    }
+}
+
+void benchmarkTicketFormatting() {
+    const size_t ticketCount = 10000;
+    const size_t seatsPerPlane = 144;
+    const char* zones[] = {"front", "center", "back"};
+    BenchmarkFixture fixture("ticket-formatting", (ticketCount + seatsPerPlane - 1) / seatsPerPlane);
+    BookingEngine engine(fixture);
+    for (size_t i = 0; i < ticketCount; i++) {
+        size_t plane = i / seatsPerPlane;
+        engine.ticket.bookBestSeat(fixture.planeId(plane), fixture.time(plane), zones[i % seatsPerPlane / 48], AnySeat, "frequent-flyer");
+    }
+    string buffer;
+    engine.ticket.writeUserTickets("frequent-flyer", buffer);
+    size_t freshAllocations = 0, reusedAllocations = 0, streamedAllocations = 0;
+    double freshSeconds = measureSeconds([&] {
+        freshAllocations = countAllocations([&] {
+            string result = engine.ticket.userTickets("frequent-flyer");
+        });
+    });
+    double reusedSeconds = measureSeconds([&] {
+        reusedAllocations = countAllocations([&] {
+            buffer.clear();
+            engine.ticket.writeUserTickets("frequent-flyer", buffer);
+        });
+    });
+    NullBuffer nullBuffer;
+    ostream nullStream(&nullBuffer);
+    double streamedSeconds = measureSeconds([&] {
+        streamedAllocations = countAllocations([&] {
+            engine.ticket.streamUserTickets("frequent-flyer", nullStream);
+        });
+    });
+    cout << "User ticket listing, " << ticketCount << " tickets, " << buffer.size() << " bytes:\n";
+    cout << "  new string:      " << freshSeconds * 1000 << " ms, " << freshAllocations << " allocations (" << double(freshAllocations) / ticketCount << " per ticket)\n";
+    cout << "  reused buffer:   " << reusedSeconds * 1000 << " ms, " << reusedAllocations << " allocations (" << double(reusedAllocations) / ticketCount << " per ticket)\n";
+    cout << "  streamed:        " << streamedSeconds * 1000 << " ms, " << streamedAllocations << " allocations (" << double(streamedAllocations) / ticketCount << " per ticket)" << endl;
+}
+
+int main() {
+    benchmarkSeatParsing();
+    benchmarkHotFlight();
+    benchmarkTicketFormatting();
+    benchmarkScaling();
+    return 0;
+}
@@ -0,0 +1,2305 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <cstring>
+#include <charconv>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <array>
+#include <chrono>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <set>
+#include <deque>
+#include <shared_mutex>
+#include <filesystem>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+using namespace std;
+using json = nlohmann::json;
+
+using SeatCode = uint16_t;
+
+constexpr SeatCode kInvalidSeat = 0;
+
+constexpr array<int8_t, 256> makeSeatColumnTable() {
+    array<int8_t, 256> table{};
+    for (int c = 0; c < 256; c++) {
+        table[c] = -1;
+    }
+    for (int column = 0; column < 26; column++) {
+        table['A' + column] = column;
+    }
+    return table;
+}
+
+constexpr array<int8_t, 256> kSeatColumns = makeSeatColumnTable();
+
+constexpr SeatCode packSeat(int row, int column) {
+    return SeatCode(row << 8 | column);
+}
+
+constexpr int seatRow(SeatCode seat) {
+    return seat >> 8;
+}
+
+constexpr int seatColumn(SeatCode seat) {
+    return seat & 0xFF;
+}
+
+constexpr SeatCode parseSeat(string_view seat) {
+    if (seat.size() < 2 || seat.size() > 4) {
+        return kInvalidSeat;
+    }
+    int row = 0;
+    for (size_t i = 0; i + 1 < seat.size(); i++) {
+        if (seat[i] < '0' || seat[i] > '9') {
+            return kInvalidSeat;
+        }
+        row = row * 10 + (seat[i] - '0');
+    }
+    int column = kSeatColumns[static_cast<unsigned char>(seat.back())];
+    if (row == 0 || row > 255 || column < 0) {
+        return kInvalidSeat;
+    }
+    return packSeat(row, column);
+}
+
+inline int countTrailingZeros(uint64_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
+inline int countSeats(uint64_t bits) {
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(bits));
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+constexpr size_t kSeatCountLanes = 4;
+
+inline unsigned matchSeatCounts(const uint64_t* words, int count) {
+#if defined(__AVX2__)
+    const __m256i nibbleCounts = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibbles = _mm256_set1_epi8(0x0F);
+    __m256i bits = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(words));
+    __m256i low = _mm256_shuffle_epi8(nibbleCounts, _mm256_and_si256(bits, lowNibbles));
+    __m256i high = _mm256_shuffle_epi8(nibbleCounts, _mm256_and_si256(_mm256_srli_epi64(bits, 4), lowNibbles));
+    __m256i counts = _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256());
+    __m256i matches = _mm256_cmpgt_epi64(counts, _mm256_set1_epi64x(int64_t(count) - 1));
+    return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(matches)));
+#elif defined(__aarch64__)
+    unsigned matches = 0;
+    for (size_t lane = 0; lane < kSeatCountLanes; lane += 2) {
+        uint64x2_t counts = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(vcntq_u8(vreinterpretq_u8_u64(vld1q_u64(words + lane))))));
+        uint64x2_t found = vcgeq_s64(vreinterpretq_s64_u64(counts), vdupq_n_s64(count));
+        matches |= unsigned(vgetq_lane_u64(found, 0) & 1) << lane | unsigned(vgetq_lane_u64(found, 1) & 1) << (lane + 1);
+    }
+    return matches;
+#else
+    unsigned matches = 0;
+    for (size_t lane = 0; lane < kSeatCountLanes; lane++) {
+        matches |= unsigned(countSeats(words[lane]) >= count) << lane;
+    }
+    return matches;
+#endif
+}
+
+inline char* writeSeat(char* out, SeatCode seat) {
+    out = to_chars(out, out + 3, seatRow(seat)).ptr;
+    *out++ = char('A' + seatColumn(seat));
+    return out;
+}
+
+inline string formatSeat(SeatCode seat) {
+    char buffer[4];
+    return string(buffer, writeSeat(buffer, seat));
+}
+
+class FileHandler {
+public:
+    FileHandler(const string& filename) : filename_(filename) {}
+
+    json loadJsonData() {
+        ifstream file(filename_);
+        json jsonData;
+        file >> jsonData;
+        file.close();
+        return jsonData;
+    }
+
+    void writeJsonData(const json& data) {
+        ofstream file(filename_);
+        file << data.dump(2);
+        file.close();
+    }
+private:
+    string filename_;
+};
+
+class FlightSchedule {
+public:
+    FlightSchedule(FileHandler& flightDataHandler) : flightDataHandler_(flightDataHandler) {
+        schedule_ = flightDataHandler_.loadJsonData();
+        for (const auto& departureCity : schedule_.items()) {
+            for (const auto& destinationCity : departureCity.value().items()) {
+                for (const auto& day : destinationCity.value().items()) {
+                    for (const auto& flight : day.value().items()) {
+                        json& details = flights_[{flight.key(), flight.value().get<string>()}];
+                        details["week_day"] = day.key();
+                        details["departure_city"] = departureCity.key();
+                        details["destination_city"] = destinationCity.key();
+                    }
+                }
+            }
+        }
+    }
+
+    const json& loadSchedule() const {
+        return schedule_;
+    }
+
+    json checkPlanes(const string& city1, const string& city2) const {
+        if (schedule_.contains(city1) && schedule_.at(city1).contains(city2)) {
+            return schedule_.at(city1).at(city2);
+        }
+        return json();
+    }
+
+    json getFlightDetails(const string& planeId, const string& time) const {
+        auto it = flights_.find({planeId, time});
+        return it != flights_.end() ? it->second : json();
+    }
+private:
+    FileHandler flightDataHandler_;
+    json schedule_;
+    map<pair<string, string>, json> flights_;
+};
+
+enum SeatPreference {
+    AnySeat,
+    WindowSeat,
+    AisleSeat
+};
+
+struct SeatReservation {
+    SeatCode seat = kInvalidSeat;
+    uint8_t zone = 0;
+    int price = 0;
+};
+
+class Airplane {
+public:
+    Airplane(FileHandler& planeDataHandler) {
+        json planeData = planeDataHandler.loadJsonData();
+        for (const auto& layoutInfo : planeData["layouts"].items()) {
+            Layout layout;
+            string error;
+            for (size_t zone = 0; zone < kZoneCount && error.empty(); zone++) {
+                loadZoneLayout(layoutInfo.value()[kZoneNames[zone]], layout.zones[zone], error);
+            }
+            if (error.empty()) {
+                layouts_[layoutInfo.key()] = layout;
+            } else {
+                loadErrors_.push_back("Layout " + layoutInfo.key() + " skipped: " + error);
+            }
+        }
+        size_t planeCount = 0;
+        for (const auto& plane : planeData["planes"].items()) {
+            const string layoutName = plane.value()["layout"].get<string>();
+            if (layouts_.count(layoutName)) {
+                planeCount++;
+            } else {
+                loadErrors_.push_back("Plane " + plane.key() + " skipped: layout " + layoutName + " is not loaded");
+            }
+        }
+        freeSeats_ = make_unique<atomic<uint64_t>[]>(planeCount * kZoneCount);
+        for (const auto& plane : planeData["planes"].items()) {
+            auto layout = layouts_.find(plane.value()["layout"].get<string>());
+            if (layout == layouts_.end()) {
+                continue;
+            }
+            Plane& inventory = planes_[plane.key()];
+            for (size_t zone = 0; zone < kZoneCount; zone++) {
+                atomic<uint64_t>& freeSeats = freeSeats_[zone * planeCount + planeIds_.size()];
+                inventory.zones[zone] = loadZone(layout->second.zones[zone], plane.value()[kZoneNames[zone]], freeSeats);
+            }
+            planeIds_.push_back(plane.key());
+        }
+    }
+
+    const vector<string>& loadErrors() const {
+        return loadErrors_;
+    }
+
+    vector<SeatReservation> reserveGroup(const string& planeId, const string& zoneName, int count) {
+        vector<SeatReservation> reservations;
+        auto it = planes_.find(planeId);
+        if (it == planes_.end() || count < 1) {
+            return reservations;
+        }
+        for (bool sameRow : {true, false}) {
+            for (size_t i = 0; i < kZoneCount; i++) {
+                if (zoneName != "any" && zoneName != kZoneNames[i]) {
+                    continue;
+                }
+                Zone& zone = it->second.zones[i];
+                uint64_t seats = claimSeats(zone, [sameRow, count](uint64_t freeSeats) {
+                    return sameRow ? findRowRun(freeSeats, count) : findRowBlock(freeSeats, count);
+                });
+                if (seats == 0) {
+                    continue;
+                }
+                for (; seats != 0; seats &= seats - 1) {
+                    reservations.push_back({seatAt(zone, countTrailingZeros(seats)), static_cast<uint8_t>(i), zone.price});
+                }
+                return reservations;
+            }
+        }
+        return reservations;
+    }
+
+    json checkSeats(const string& planeId) {
+        json result;
+        auto it = planes_.find(planeId);
+        if (it == planes_.end()) {
+            return result;
+        }
+        result["free_seats"] = countFreeSeats(it->second);
+        for (size_t zone = 0; zone < kZoneCount; zone++) {
+            json zoneInfo;
+            zoneInfo["free_seats"] = seatList(it->second.zones[zone]);
+            zoneInfo["price"] = it->second.zones[zone].price;
+            result[kZoneNames[zone]] = zoneInfo;
+        }
+        return result;
+    }
+
+    SeatReservation reserveSeat(const string& planeId, SeatCode seat) {
+        SeatReservation reservation;
+        Zone* zone = findZone(planeId, seat);
+        uint64_t bit = zone ? seatBit(*zone, seat) : 0;
+        if (bit != 0 && claimSeats(*zone, [bit](uint64_t freeSeats) { return freeSeats & bit; })) {
+            reservation.seat = seat;
+            reservation.zone = static_cast<uint8_t>(zone - planes_.at(planeId).zones);
+            reservation.price = zone->price;
+        }
+        return reservation;
+    }
+
+    SeatReservation reserveBestSeat(const string& planeId, const string& zoneName, SeatPreference preference) {
+        SeatReservation reservation;
+        auto it = planes_.find(planeId);
+        if (it == planes_.end()) {
+            return reservation;
+        }
+        for (size_t i = 0; i < kZoneCount; i++) {
+            if (zoneName != kZoneNames[i]) {
+                continue;
+            }
+            Zone& zone = it->second.zones[i];
+            uint64_t seat = claimSeats(zone, [&zone, preference](uint64_t candidates) {
+                if (preference == WindowSeat && (candidates & zone.layout->windowSeats)) {
+                    candidates &= zone.layout->windowSeats;
+                } else if (preference == AisleSeat && (candidates & zone.layout->aisleSeats)) {
+                    candidates &= zone.layout->aisleSeats;
+                }
+                return candidates & (~candidates + 1);
+            });
+            if (seat != 0) {
+                reservation.seat = seatAt(zone, countTrailingZeros(seat));
+                reservation.zone = static_cast<uint8_t>(i);
+                reservation.price = zone.price;
+            }
+        }
+        return reservation;
+    }
+
+    void releaseSeat(const string& planeId, uint8_t zone, SeatCode seat) {
+        auto it = planes_.find(planeId);
+        if (it == planes_.end() || zone >= kZoneCount) {
+            return;
+        }
+        it->second.zones[zone].freeSeats->fetch_or(seatBit(it->second.zones[zone], seat), memory_order_acq_rel);
+    }
+
+    int getMinPrice(const string& planeId) const {
+        auto it = planes_.find(planeId);
+        if (it == planes_.end()) {
+            return 0;
+        }
+        int minPrice = 0;
+        for (const Zone& zone : it->second.zones) {
+            if (zone.freeSeats->load(memory_order_relaxed) != 0 && (minPrice == 0 || zone.price < minPrice)) {
+                minPrice = zone.price;
+            }
+        }
+        return minPrice;
+    }
+
+    json planesWithFreeSeats(const string& zoneName, int count) const {
+        json result = json::array();
+        uint8_t zone;
+        if (!findZoneIndex(zoneName, zone)) {
+            return result;
+        }
+        size_t planeCount = planeIds_.size();
+        const atomic<uint64_t>* freeSeats = &freeSeats_[zone * planeCount];
+        for (size_t first = 0; first < planeCount; first += kSeatCountLanes) {
+            uint64_t words[kSeatCountLanes] = {};
+            size_t lanes = min(kSeatCountLanes, planeCount - first);
+            for (size_t lane = 0; lane < lanes; lane++) {
+                words[lane] = freeSeats[first + lane].load(memory_order_relaxed);
+            }
+            unsigned matches = matchSeatCounts(words, count) & ((1u << lanes) - 1);
+            for (; matches != 0; matches &= matches - 1) {
+                result.push_back(planeIds_[first + countTrailingZeros(matches)]);
+            }
+        }
+        return result;
+    }
+
+    static bool findZoneIndex(const string& zoneName, uint8_t& zone) {
+        auto it = find(begin(kZoneNames), end(kZoneNames), zoneName);
+        zone = static_cast<uint8_t>(it - begin(kZoneNames));
+        return it != end(kZoneNames);
+    }
+
+    int getFreeSeats(const string& planeId) const {
+        auto it = planes_.find(planeId);
+        return it != planes_.end() ? countFreeSeats(it->second) : 0;
+    }
+
+    vector<SeatCode> takenSeats(const string& planeId) const {
+        vector<SeatCode> seats;
+        auto it = planes_.find(planeId);
+        if (it == planes_.end()) {
+            return seats;
+        }
+        for (const Zone& zone : it->second.zones) {
+            for (uint64_t bits = zone.layout->seats & ~zone.freeSeats->load(memory_order_acquire); bits != 0; bits &= bits - 1) {
+                seats.push_back(seatAt(zone, countTrailingZeros(bits)));
+            }
+        }
+        return seats;
+    }
+
+private:
+    static constexpr size_t kZoneCount = 3;
+    static constexpr int kSeatsPerRow = 8;
+    static constexpr int kMaxZoneRows = 64 / kSeatsPerRow;
+    static constexpr uint64_t kRowMask = (uint64_t(1) << kSeatsPerRow) - 1;
+    static constexpr uint64_t kEveryRow = 0x0101010101010101;
+    static constexpr const char* kZoneNames[kZoneCount] = {"front", "center", "back"};
+
+    struct ZoneLayout {
+        int firstRow = 0;
+        int lastRow = 0;
+        uint64_t seats = 0;
+        uint64_t windowSeats = 0;
+        uint64_t aisleSeats = 0;
+    };
+
+    struct Layout {
+        ZoneLayout zones[kZoneCount];
+    };
+
+    struct Zone {
+        const ZoneLayout* layout = nullptr;
+        int price = 0;
+        atomic<uint64_t>* freeSeats = nullptr;
+    };
+
+    struct Plane {
+        Zone zones[kZoneCount];
+    };
+
+    static uint64_t seatMask(const ZoneLayout& zone, SeatCode seat) {
+        int row = seatRow(seat) - zone.firstRow;
+        int column = seatColumn(seat);
+        if (row < 0 || row >= kMaxZoneRows || column >= kSeatsPerRow) {
+            return 0;
+        }
+        return uint64_t(1) << (row * kSeatsPerRow + column);
+    }
+
+    static uint64_t runStarts(uint64_t freeSeats, int count) {
+        uint64_t starts = freeSeats & ((uint64_t(1) << (kSeatsPerRow - count + 1)) - 1) * kEveryRow;
+        for (int i = 1; i < count; i++) {
+            starts &= freeSeats >> i;
+        }
+        return starts;
+    }
+
+    static uint64_t findRowRun(uint64_t freeSeats, int count) {
+        if (count > kSeatsPerRow) {
+            return 0;
+        }
+        uint64_t starts = runStarts(freeSeats, count);
+        if (starts == 0) {
+            return 0;
+        }
+        return ((uint64_t(1) << count) - 1) << countTrailingZeros(starts);
+    }
+
+    static uint64_t findRowBlock(uint64_t freeSeats, int count) {
+        for (int rows = 2; rows <= kMaxZoneRows; rows++) {
+            int width = (count + rows - 1) / rows;
+            int lastWidth = count - (rows - 1) * width;
+            if (width > kSeatsPerRow || lastWidth < 1) {
+                continue;
+            }
+            uint64_t fullRows = runStarts(freeSeats, width);
+            uint64_t starts = runStarts(freeSeats, lastWidth) >> ((rows - 1) * kSeatsPerRow);
+            for (int row = 0; row < rows - 1; row++) {
+                starts &= fullRows >> (row * kSeatsPerRow);
+            }
+            if (starts == 0) {
+                continue;
+            }
+            int start = countTrailingZeros(starts);
+            uint64_t seats = ((uint64_t(1) << lastWidth) - 1) << (start + (rows - 1) * kSeatsPerRow);
+            for (int row = 0; row < rows - 1; row++) {
+                seats |= ((uint64_t(1) << width) - 1) << (start + row * kSeatsPerRow);
+            }
+            return seats;
+        }
+        return 0;
+    }
+
+    static SeatCode seatAt(const Zone& zone, int bit) {
+        return packSeat(zone.layout->firstRow + bit / kSeatsPerRow, bit % kSeatsPerRow);
+    }
+
+    static uint64_t seatBit(const Zone& zone, SeatCode seat) {
+        return zone.layout->seats & seatMask(*zone.layout, seat);
+    }
+
+    static bool loadZoneLayout(const json& zoneInfo, ZoneLayout& zone, string& error) {
+        zone.firstRow = zoneInfo["rows"][0];
+        zone.lastRow = zoneInfo["rows"][1];
+        if (zone.firstRow < 1 || zone.lastRow < zone.firstRow || zone.lastRow - zone.firstRow >= kMaxZoneRows) {
+            error = "zone rows " + to_string(zone.firstRow) + "-" + to_string(zone.lastRow) + " exceed the " + to_string(kMaxZoneRows) + "-row zone limit";
+            return false;
+        }
+        uint64_t rowSeats = 0;
+        for (char letter : zoneInfo["columns"].get<string>()) {
+            int column = kSeatColumns[static_cast<unsigned char>(letter)];
+            if (column < 0 || column >= kSeatsPerRow) {
+                error = string("column ") + letter + " exceeds the " + to_string(kSeatsPerRow) + "-column zone limit";
+                return false;
+            }
+            rowSeats |= uint64_t(1) << column;
+        }
+        for (int row = 0; row <= zone.lastRow - zone.firstRow; row++) {
+            zone.seats |= rowSeats << (row * kSeatsPerRow);
+        }
+        for (int row = 0; row < kMaxZoneRows; row++) {
+            int columns[kSeatsPerRow];
+            int columnCount = 0;
+            for (int column = 0; column < kSeatsPerRow; column++) {
+                if (zone.seats & (uint64_t(1) << (row * kSeatsPerRow + column))) {
+                    columns[columnCount++] = row * kSeatsPerRow + column;
+                }
+            }
+            if (columnCount >= 2) {
+                zone.windowSeats |= uint64_t(1) << columns[0] | uint64_t(1) << columns[columnCount - 1];
+            }
+            if (columnCount >= 4) {
+                zone.aisleSeats |= uint64_t(1) << columns[(columnCount - 1) / 2] | uint64_t(1) << columns[columnCount / 2];
+            }
+        }
+        return true;
+    }
+
+    static Zone loadZone(const ZoneLayout& layout, const json& zoneInfo, atomic<uint64_t>& freeSeats) {
+        Zone zone;
+        zone.layout = &layout;
+        zone.price = zoneInfo["price"];
+        zone.freeSeats = &freeSeats;
+        uint64_t seats = 0;
+        for (const auto& seatName : zoneInfo["free_seats"]) {
+            seats |= seatBit(zone, parseSeat(seatName.get<string>()));
+        }
+        freeSeats.store(seats, memory_order_relaxed);
+        return zone;
+    }
+
+    template <typename Pick>
+    static uint64_t claimSeats(Zone& zone, Pick pick) {
+        uint64_t freeSeats = zone.freeSeats->load(memory_order_acquire);
+        while (true) {
+            uint64_t seats = pick(freeSeats);
+            if (seats == 0) {
+                return 0;
+            }
+            if (zone.freeSeats->compare_exchange_weak(freeSeats, freeSeats & ~seats, memory_order_acq_rel, memory_order_acquire)) {
+                return seats;
+            }
+        }
+    }
+
+    static json seatList(const Zone& zone) {
+        json seats = json::array();
+        for (uint64_t bits = zone.freeSeats->load(memory_order_acquire); bits != 0; bits &= bits - 1) {
+            seats.push_back(formatSeat(seatAt(zone, countTrailingZeros(bits))));
+        }
+        return seats;
+    }
+
+    static int countFreeSeats(const Plane& plane) {
+        int freeSeats = 0;
+        for (const Zone& zone : plane.zones) {
+            freeSeats += countSeats(zone.freeSeats->load(memory_order_relaxed));
+        }
+        return freeSeats;
+    }
+
+    Zone* findZone(const string& planeId, SeatCode seat) {
+        auto it = planes_.find(planeId);
+        if (it == planes_.end()) {
+            return nullptr;
+        }
+        int row = seatRow(seat);
+        for (Zone& zone : it->second.zones) {
+            if (row >= zone.layout->firstRow && row <= zone.layout->lastRow) {
+                return &zone;
+            }
+        }
+        return nullptr;
+    }
+
+    map<string, Layout> layouts_;
+    map<string, Plane> planes_;
+    vector<string> planeIds_;
+    unique_ptr<atomic<uint64_t>[]> freeSeats_;
+    vector<string> loadErrors_;
+};
+
+class FareSearch {
+public:
+    FareSearch(FlightSchedule& flightSchedule, Airplane& airplane) : flightSchedule_(flightSchedule), airplane_(airplane) {}
+
+    json cheapestFlights(const string& city1, const string& city2, size_t count) {
+        json planes = flightSchedule_.checkPlanes(city1, city2);
+        vector<Fare> fares;
+        for (const auto& day : planes.items()) {
+            for (const auto& flight : day.value().items()) {
+                int price = airplane_.getMinPrice(flight.key());
+                if (price != 0) {
+                    fares.push_back({price, day.key(), flight.key(), flight.value()});
+                }
+            }
+        }
+        count = min(count, fares.size());
+        partial_sort(fares.begin(), fares.begin() + count, fares.end(), [](const Fare& fare1, const Fare& fare2) {
+            return fare1.price < fare2.price;
+        });
+        json result = json::array();
+        for (size_t i = 0; i < count; i++) {
+            result.push_back({{"plane_id", fares[i].planeId}, {"week_day", fares[i].weekDay}, {"time", fares[i].time}, {"price", fares[i].price}});
+        }
+        return result;
+    }
+private:
+    struct Fare {
+        int price;
+        string weekDay;
+        string planeId;
+        string time;
+    };
+
+    FlightSchedule& flightSchedule_;
+    Airplane& airplane_;
+};
+
+class AvailabilityHeatmap {
+public:
+    AvailabilityHeatmap(FlightSchedule& flightSchedule, Airplane& airplane) {
+        const json& jsonData = flightSchedule.loadSchedule();
+        for (const auto& departureCity : jsonData.items()) {
+            for (const auto& destinationCity : departureCity.value().items()) {
+                for (const auto& day : destinationCity.value().items()) {
+                    size_t cell = cellKeys_.size();
+                    cellKeys_.push_back({departureCity.key(), destinationCity.key(), day.key()});
+                    for (const auto& flight : day.value().items()) {
+                        planeCells_[flight.key()].push_back(cell);
+                    }
+                }
+            }
+        }
+        cells_ = make_unique<atomic<int>[]>(cellKeys_.size());
+        for (const auto& plane : planeCells_) {
+            int freeSeats = airplane.getFreeSeats(plane.first);
+            for (size_t cell : plane.second) {
+                cells_[cell].fetch_add(freeSeats, memory_order_relaxed);
+            }
+        }
+    }
+
+    void seatBooked(const string& planeId) {
+        addFreeSeats(planeId, -1);
+    }
+
+    void seatRefunded(const string& planeId) {
+        addFreeSeats(planeId, 1);
+    }
+
+    json freeSeatsByDay() const {
+        json result;
+        for (size_t cell = 0; cell < cellKeys_.size(); cell++) {
+            const CellKey& key = cellKeys_[cell];
+            result[key.departure][key.destination][key.weekDay] = cells_[cell].load(memory_order_relaxed);
+        }
+        return result;
+    }
+private:
+    struct CellKey {
+        string departure;
+        string destination;
+        string weekDay;
+    };
+
+    void addFreeSeats(const string& planeId, int delta) {
+        auto it = planeCells_.find(planeId);
+        if (it != planeCells_.end()) {
+            for (size_t cell : it->second) {
+                cells_[cell].fetch_add(delta, memory_order_relaxed);
+            }
+        }
+    }
+
+    vector<CellKey> cellKeys_;
+    map<string, vector<size_t>> planeCells_;
+    unique_ptr<atomic<int>[]> cells_;
+};
+
+class StringPool {
+public:
+    uint32_t intern(const string& value) {
+        uint32_t id;
+        if (find(value, id)) {
+            return id;
+        }
+        unique_lock<shared_mutex> lock(lock_);
+        auto it = ids_.find(value);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        id = static_cast<uint32_t>(values_.size());
+        values_.push_back(value);
+        ids_.emplace(value, id);
+        return id;
+    }
+
+    const string& name(uint32_t id) const {
+        shared_lock<shared_mutex> lock(lock_);
+        return values_[id];
+    }
+
+    bool find(const string& value, uint32_t& id) const {
+        shared_lock<shared_mutex> lock(lock_);
+        auto it = ids_.find(value);
+        if (it == ids_.end()) {
+            return false;
+        }
+        id = it->second;
+        return true;
+    }
+private:
+    mutable shared_mutex lock_;
+    deque<string> values_;
+    unordered_map<string, uint32_t> ids_;
+};
+
+constexpr string_view kWeekDays[] = {"Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday", "Sunday"};
+
+inline bool parseDeparture(string_view weekDay, string_view time, uint32_t& minuteOfWeek) {
+    auto day = find(begin(kWeekDays), end(kWeekDays), weekDay);
+    uint32_t hours = 0, minutes = 0;
+    size_t colon = time.find(':');
+    if (day == end(kWeekDays) || colon == string_view::npos || colon == 0 || time.size() - colon != 3) {
+        return false;
+    }
+    auto hoursResult = from_chars(time.data(), time.data() + colon, hours);
+    auto minutesResult = from_chars(time.data() + colon + 1, time.data() + time.size(), minutes);
+    if (hoursResult.ptr != time.data() + colon || minutesResult.ptr != time.data() + time.size() || hours > 23 || minutes > 59) {
+        return false;
+    }
+    minuteOfWeek = static_cast<uint32_t>(day - begin(kWeekDays)) * 24 * 60 + hours * 60 + minutes;
+    return true;
+}
+
+struct TicketRecord {
+    uint32_t planeId;
+    uint32_t departureCity;
+    uint32_t destinationCity;
+    uint32_t weekDay;
+    uint32_t time;
+    SeatCode seat;
+    uint8_t zone;
+    int32_t price;
+    uint32_t owner;
+    uint32_t departure;
+};
+
+class TicketStore {
+public:
+    TicketStore() : slots_(kInitialCapacity) {}
+
+    TicketRecord* find(uint64_t ticketId) {
+        size_t slot = findSlot(ticketId);
+        return slot != kNotFound ? &slots_[slot].record : nullptr;
+    }
+
+    bool insert(uint64_t ticketId, const TicketRecord& record) {
+        if (ticketId == kEmpty || ticketId == kDeleted || findSlot(ticketId) != kNotFound) {
+            return false;
+        }
+        if ((used_ + 1) * 10 > slots_.size() * 7) {
+            rehash(size_ * 2 >= slots_.size() / 2 ? slots_.size() * 2 : slots_.size());
+        }
+        size_t i = hashId(ticketId) & mask();
+        while (slots_[i].ticketId != kEmpty && slots_[i].ticketId != kDeleted) {
+            i = (i + 1) & mask();
+        }
+        if (slots_[i].ticketId == kEmpty) {
+            used_++;
+        }
+        slots_[i] = {ticketId, record};
+        size_++;
+        return true;
+    }
+
+    bool erase(uint64_t ticketId) {
+        size_t slot = findSlot(ticketId);
+        if (slot == kNotFound) {
+            return false;
+        }
+        slots_[slot].ticketId = kDeleted;
+        size_--;
+        return true;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const Slot& slot : slots_) {
+            if (slot.ticketId != kEmpty && slot.ticketId != kDeleted) {
+                visit(slot.ticketId, slot.record);
+            }
+        }
+    }
+private:
+    static constexpr uint64_t kEmpty = 0;
+    static constexpr uint64_t kDeleted = ~uint64_t(0);
+    static constexpr size_t kInitialCapacity = 1024;
+    static constexpr size_t kNotFound = ~size_t(0);
+
+    struct Slot {
+        uint64_t ticketId = kEmpty;
+        TicketRecord record{};
+    };
+
+    static uint64_t hashId(uint64_t ticketId) {
+        ticketId ^= ticketId >> 33;
+        ticketId *= 0xff51afd7ed558ccd;
+        ticketId ^= ticketId >> 33;
+        return ticketId;
+    }
+
+    size_t findSlot(uint64_t ticketId) const {
+        if (ticketId == kEmpty || ticketId == kDeleted) {
+            return kNotFound;
+        }
+        for (size_t i = hashId(ticketId) & mask();; i = (i + 1) & mask()) {
+            if (slots_[i].ticketId == ticketId) {
+                return i;
+            }
+            if (slots_[i].ticketId == kEmpty) {
+                return kNotFound;
+            }
+        }
+    }
+
+    size_t mask() const {
+        return slots_.size() - 1;
+    }
+
+    void rehash(size_t capacity) {
+        vector<Slot> slots(capacity);
+        slots.swap(slots_);
+        used_ = 0;
+        size_ = 0;
+        for (const Slot& slot : slots) {
+            if (slot.ticketId != kEmpty && slot.ticketId != kDeleted) {
+                insert(slot.ticketId, slot.record);
+            }
+        }
+    }
+
+    vector<Slot> slots_;
+    size_t size_ = 0;
+    size_t used_ = 0;
+};
+
+class TicketIdGenerator {
+public:
+    using Keys = array<uint32_t, 4>;
+
+    TicketIdGenerator(uint64_t session, const Keys& keys) : generation_(nextGeneration()), keys_(keys), nextBlock_(session << kSessionShift) {}
+
+    static Keys randomKeys() {
+        random_device rd;
+        Keys keys;
+        for (uint32_t& key : keys) {
+            key = rd();
+        }
+        return keys;
+    }
+
+    const Keys& keys() const {
+        return keys_;
+    }
+
+    uint64_t next() {
+        thread_local uint64_t owner = 0;
+        thread_local uint64_t counter = 0;
+        thread_local uint64_t blockEnd = 0;
+        while (true) {
+            if (owner != generation_ || counter == blockEnd) {
+                owner = generation_;
+                counter = nextBlock_.fetch_add(kBlockSize, memory_order_relaxed);
+                blockEnd = counter + kBlockSize;
+            }
+            uint64_t id = permute(counter++);
+            if (id != 0 && id != ~uint64_t(0)) {
+                return id;
+            }
+        }
+    }
+
+    static char* write(char* out, uint64_t id) {
+        char code[kMaxCodeLength];
+        int length = 0;
+        do {
+            code[length++] = kAlphabet[id & 31];
+            id >>= 5;
+        } while (id != 0);
+        while (length > 0) {
+            *out++ = code[--length];
+        }
+        return out;
+    }
+
+    static string format(uint64_t id) {
+        char buffer[kMaxCodeLength];
+        return string(buffer, write(buffer, id));
+    }
+
+    static uint64_t parse(const string& code) {
+        if (code.empty() || code.size() > kMaxCodeLength) {
+            return 0;
+        }
+        uint64_t id = 0;
+        for (char symbol : code) {
+            const char* position = strchr(kAlphabet, toupper(static_cast<unsigned char>(symbol)));
+            if (symbol == '\0' || !position || (id >> 59) != 0) {
+                return 0;
+            }
+            id = id << 5 | uint64_t(position - kAlphabet);
+        }
+        return id;
+    }
+private:
+    static constexpr int kSessionShift = 40;
+    static constexpr size_t kMaxCodeLength = 13;
+    static constexpr uint64_t kBlockSize = 1024;
+    static constexpr const char* kAlphabet = "0123456789ABCDEFGHJKMNPQRSTVWXYZ";
+
+    static uint64_t nextGeneration() {
+        static atomic<uint64_t> generations(0);
+        return generations.fetch_add(1, memory_order_relaxed) + 1;
+    }
+
+    static uint32_t round(uint32_t half, uint32_t key) {
+        uint32_t value = half ^ key;
+        value ^= value >> 16;
+        value *= 0x7feb352d;
+        value ^= value >> 15;
+        value *= 0x846ca68b;
+        value ^= value >> 16;
+        return value;
+    }
+
+    uint64_t permute(uint64_t counter) const {
+        uint32_t left = static_cast<uint32_t>(counter >> 32);
+        uint32_t right = static_cast<uint32_t>(counter);
+        for (uint32_t key : keys_) {
+            uint32_t next = left ^ round(right, key);
+            left = right;
+            right = next;
+        }
+        return uint64_t(left) << 32 | right;
+    }
+
+    const uint64_t generation_;
+    const Keys keys_;
+    atomic<uint64_t> nextBlock_;
+};
+
+class TimingWheel {
+public:
+    TimingWheel(uint64_t now) : currentTick_(now) {}
+
+    void schedule(uint64_t id, uint64_t deadline) {
+        place({id, max(deadline, currentTick_ + 1)});
+        size_++;
+    }
+
+    void advance(uint64_t now, vector<uint64_t>& expired) {
+        if (size_ == 0) {
+            currentTick_ = max(currentTick_, now);
+            return;
+        }
+        while (currentTick_ < now && size_ != 0) {
+            currentTick_++;
+            int cascadeLevel = 0;
+            while (cascadeLevel + 1 < kLevels && (currentTick_ & ((uint64_t(1) << (kSlotBits * (cascadeLevel + 1))) - 1)) == 0) {
+                cascadeLevel++;
+            }
+            for (int level = cascadeLevel; level > 0; level--) {
+                vector<Entry> entries;
+                entries.swap(slots_[level][slotIndex(currentTick_, level)]);
+                for (const Entry& entry : entries) {
+                    place(entry);
+                }
+            }
+            vector<Entry>& slot = slots_[0][slotIndex(currentTick_, 0)];
+            for (const Entry& entry : slot) {
+                expired.push_back(entry.id);
+            }
+            size_ -= slot.size();
+            slot.clear();
+        }
+        currentTick_ = max(currentTick_, now);
+    }
+private:
+    static constexpr int kSlotBits = 6;
+    static constexpr int kSlots = 1 << kSlotBits;
+    static constexpr int kLevels = 4;
+
+    struct Entry {
+        uint64_t id;
+        uint64_t deadline;
+    };
+
+    static size_t slotIndex(uint64_t tick, int level) {
+        return (tick >> (kSlotBits * level)) & (kSlots - 1);
+    }
+
+    void place(const Entry& entry) {
+        int level = 0;
+        while (level < kLevels - 1 && (entry.deadline >> (kSlotBits * (level + 1))) != (currentTick_ >> (kSlotBits * (level + 1)))) {
+            level++;
+        }
+        slots_[level][slotIndex(entry.deadline, level)].push_back(entry);
+    }
+
+    uint64_t currentTick_;
+    size_t size_ = 0;
+    vector<Entry> slots_[kLevels][kSlots];
+};
+
+class RequestCache {
+public:
+    RequestCache(size_t capacity, uint64_t ttlSeconds) : ttlSeconds_(ttlSeconds) {
+        for (Shard& shard : shards_) {
+            shard.slots.resize(max<size_t>(capacity / kShards, 1));
+        }
+    }
+
+    bool claim(const string& key, uint64_t now, uint64_t& ticketId) {
+        Shard& shard = shardFor(key);
+        unique_lock<mutex> lock(shard.lock);
+        while (true) {
+            auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                Slot& slot = shard.slots[it->second];
+                if (slot.pending) {
+                    shard.settled.wait(lock);
+                    continue;
+                }
+                if (slot.expiresAt > now) {
+                    slot.referenced = true;
+                    ticketId = slot.ticketId;
+                    return true;
+                }
+                shard.index.erase(it);
+                slot.used = false;
+            }
+            size_t position = evict(shard, now);
+            if (position == kNoSlot) {
+                shard.settled.wait(lock);
+                continue;
+            }
+            Slot& slot = shard.slots[position];
+            slot.key = key;
+            slot.referenced = false;
+            slot.used = true;
+            slot.pending = true;
+            shard.index[key] = position;
+            return false;
+        }
+    }
+
+    void complete(const string& key, uint64_t ticketId, uint64_t now) {
+        Shard& shard = shardFor(key);
+        {
+            lock_guard<mutex> lock(shard.lock);
+            Slot& slot = shard.slots[shard.index.at(key)];
+            slot.ticketId = ticketId;
+            slot.expiresAt = now + ttlSeconds_;
+            slot.pending = false;
+        }
+        shard.settled.notify_all();
+    }
+
+    void abandon(const string& key) {
+        Shard& shard = shardFor(key);
+        {
+            lock_guard<mutex> lock(shard.lock);
+            auto it = shard.index.find(key);
+            Slot& slot = shard.slots[it->second];
+            slot.used = false;
+            slot.pending = false;
+            shard.index.erase(it);
+        }
+        shard.settled.notify_all();
+    }
+private:
+    static constexpr size_t kShards = 16;
+    static constexpr size_t kNoSlot = ~size_t(0);
+
+    struct Slot {
+        string key;
+        uint64_t ticketId = 0;
+        uint64_t expiresAt = 0;
+        bool referenced = false;
+        bool used = false;
+        bool pending = false;
+    };
+
+    struct Shard {
+        mutex lock;
+        condition_variable settled;
+        vector<Slot> slots;
+        unordered_map<string, size_t> index;
+        size_t hand = 0;
+    };
+
+    Shard& shardFor(const string& key) {
+        return shards_[hash<string>()(key) % kShards];
+    }
+
+    static size_t evict(Shard& shard, uint64_t now) {
+        for (size_t step = 0; step < shard.slots.size() * 2; step++) {
+            size_t position = shard.hand;
+            shard.hand = (shard.hand + 1) % shard.slots.size();
+            Slot& slot = shard.slots[position];
+            if (slot.pending) {
+                continue;
+            }
+            if (slot.used && slot.referenced && slot.expiresAt > now) {
+                slot.referenced = false;
+                continue;
+            }
+            if (slot.used) {
+                shard.index.erase(slot.key);
+                slot.used = false;
+            }
+            return position;
+        }
+        return kNoSlot;
+    }
+
+    uint64_t ttlSeconds_;
+    Shard shards_[kShards];
+};
+
+class BookingLedger {
+public:
+    enum EventType : uint8_t {
+        SessionEvent,
+        NameEvent,
+        BookEvent,
+        RefundEvent,
+        HoldEvent,
+        HoldReleaseEvent
+    };
+
+    struct Event {
+        uint64_t id;
+        uint32_t planeId;
+        uint32_t time;
+        uint32_t owner;
+        int32_t price;
+        SeatCode seat;
+        EventType type;
+        uint8_t zone;
+        uint32_t length;
+    };
+
+    BookingLedger(const string& filename, uint64_t validBytes) : filename_(filename) {
+        error_code error;
+        uintmax_t size = filesystem::file_size(filename_, error);
+        if (!error && size > validBytes) {
+            filesystem::resize_file(filename_, validBytes);
+        }
+        file_.open(filename_, ios::binary | ios::app);
+        if (!file_) {
+            throw runtime_error("Cannot open ledger " + filename_);
+        }
+    }
+
+    void beginSession(uint64_t session, const TicketIdGenerator::Keys& keys) {
+        lock_guard<mutex> lock(lock_);
+        Event event = {};
+        event.id = session;
+        event.planeId = keys[0];
+        event.time = keys[1];
+        event.owner = keys[2];
+        event.price = static_cast<int32_t>(keys[3]);
+        event.type = SessionEvent;
+        append(event);
+        file_.write(pending_.data(), pending_.size());
+        file_.flush();
+        pending_.clear();
+        if (!file_.good()) {
+            throw runtime_error("Cannot write ledger " + filename_);
+        }
+    }
+
+    bool record(EventType type, uint64_t id, const TicketRecord& record, const StringPool& names) {
+        unique_lock<mutex> lock(lock_);
+        if (failedFrom_ != kNoFailure) {
+            return false;
+        }
+        writeName(record.planeId, names);
+        writeName(record.time, names);
+        writeName(record.owner, names);
+        Event event = {};
+        event.id = id;
+        event.planeId = record.planeId;
+        event.time = record.time;
+        event.owner = record.owner;
+        event.price = record.price;
+        event.seat = record.seat;
+        event.type = type;
+        event.zone = record.zone;
+        append(event);
+        uint64_t sequence = ++appended_;
+        while (flushed_ < sequence) {
+            if (flushing_) {
+                flushDone_.wait(lock);
+                continue;
+            }
+            flushing_ = true;
+            uint64_t batchEnd = appended_;
+            batch_.swap(pending_);
+            lock.unlock();
+            file_.write(batch_.data(), batch_.size());
+            file_.flush();
+            bool written = file_.good();
+            batch_.clear();
+            lock.lock();
+            if (!written) {
+                failedFrom_ = min(failedFrom_, flushed_ + 1);
+            }
+            flushing_ = false;
+            flushed_ = batchEnd;
+            flushDone_.notify_all();
+        }
+        return sequence < failedFrom_;
+    }
+private:
+    static constexpr uint64_t kNoFailure = ~uint64_t(0);
+
+    void writeName(uint32_t id, const StringPool& names) {
+        if (id < namesWritten_.size() && namesWritten_[id]) {
+            return;
+        }
+        if (id >= namesWritten_.size()) {
+            namesWritten_.resize(id + 1);
+        }
+        namesWritten_[id] = true;
+        const string& value = names.name(id);
+        Event event = {};
+        event.id = id;
+        event.type = NameEvent;
+        event.length = static_cast<uint32_t>(value.size());
+        append(event);
+        pending_.append(value);
+    }
+
+    void append(const Event& event) {
+        pending_.append(reinterpret_cast<const char*>(&event), sizeof(event));
+    }
+
+    string filename_;
+    mutex lock_;
+    condition_variable flushDone_;
+    ofstream file_;
+    string pending_;
+    string batch_;
+    uint64_t appended_ = 0;
+    uint64_t flushed_ = 0;
+    uint64_t failedFrom_ = kNoFailure;
+    bool flushing_ = false;
+    vector<bool> namesWritten_;
+};
+
+class LedgerReplay {
+public:
+    LedgerReplay(const FlightSchedule& flightSchedule, const Airplane& airplane) : flightSchedule_(flightSchedule), airplane_(airplane) {}
+
+    bool load(const string& filename) {
+        error_code error;
+        if (!filesystem::is_regular_file(filename, error)) {
+            return false;
+        }
+        ifstream file(filename, ios::binary);
+        vector<char> data(static_cast<size_t>(filesystem::file_size(filename, error)));
+        file.read(data.data(), data.size());
+        ledgerBytes_ = data.size();
+        eventCount_ = decode(data);
+        atomic<size_t> nextPlane(0);
+        vector<thread> workers(max<size_t>(min<size_t>(thread::hardware_concurrency(), planes_.size()), 1));
+        for (thread& worker : workers) {
+            worker = thread([this, &nextPlane] {
+                for (size_t i = nextPlane++; i < planes_.size(); i = nextPlane++) {
+                    replayPlane(planes_[i]);
+                }
+            });
+        }
+        for (thread& worker : workers) {
+            worker.join();
+        }
+        return true;
+    }
+
+    bool run(const string& filename, ostream& out) {
+        auto start = chrono::steady_clock::now();
+        if (!load(filename)) {
+            return false;
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        size_t tickets = 0, holds = 0, conflicts = 0;
+        for (const PlaneState& plane : planes_) {
+            tickets += plane.tickets.size();
+            holds += plane.holds.size();
+            conflicts += plane.conflicts;
+        }
+        out << "Replayed " << eventCount_ << " events in " << seconds * 1000 << " ms (" << static_cast<uint64_t>(eventCount_ / max(seconds, 1e-9)) << " events/s)\n";
+        if (corrupt()) {
+            out << "Stopped at a corrupt event at byte " << validBytes_ << "\n";
+        } else if (validBytes_ < ledgerBytes_) {
+            out << "Ignored " << ledgerBytes_ - validBytes_ << " bytes of an incomplete write at the end\n";
+        }
+        out << "Tickets: " << tickets << ", open holds: " << holds << ", conflicts: " << conflicts << "\n";
+        for (const PlaneState& plane : planes_) {
+            out << names_.name(plane.planeId) << ": " << plane.tickets.size() << " tickets, " << plane.holds.size() << " holds, " << plane.occupied << " occupied seats\n";
+        }
+        return true;
+    }
+
+    uint64_t sessions() const {
+        return session_;
+    }
+
+    bool corrupt() const {
+        return corrupt_;
+    }
+
+    size_t validBytes() const {
+        return validBytes_;
+    }
+
+    bool idKeys(TicketIdGenerator::Keys& keys) const {
+        keys = idKeys_;
+        return hasIdKeys_;
+    }
+
+    template <typename Visitor>
+    void forEachTicket(Visitor visit) const {
+        for (const PlaneState& plane : planes_) {
+            plane.tickets.forEach([&](uint64_t id, const TicketRecord& record) {
+                visit(id, record, names_);
+            });
+        }
+    }
+private:
+    static constexpr size_t kSeatWords = (size_t(1) << 16) / 64;
+    static constexpr uint32_t kNoPlane = ~uint32_t(0);
+
+    struct Route {
+        uint32_t departureCity;
+        uint32_t destinationCity;
+        uint32_t weekDay;
+        uint32_t departure;
+    };
+
+    struct PlaneState {
+        uint32_t planeId;
+        vector<pair<uint64_t, BookingLedger::Event>> events;
+        vector<uint64_t> seats;
+        TicketStore tickets;
+        unordered_map<uint64_t, SeatCode> holds;
+        size_t occupied = 0;
+        size_t conflicts = 0;
+    };
+
+    size_t decode(const vector<char>& data) {
+        vector<uint32_t> sessionNames;
+        size_t eventCount = 0;
+        size_t offset = 0;
+        BookingLedger::Event event;
+        while (offset + sizeof(event) <= data.size()) {
+            memcpy(&event, data.data() + offset, sizeof(event));
+            if (event.type == BookingLedger::NameEvent && event.id >= data.size()) {
+                corrupt_ = true;
+                break;
+            }
+            if (event.type == BookingLedger::NameEvent && event.length > data.size() - offset - sizeof(event)) {
+                break;
+            }
+            offset += sizeof(event);
+            eventCount++;
+            if (event.type == BookingLedger::SessionEvent) {
+                sessionNames.clear();
+                session_++;
+                if (event.planeId != 0 || event.time != 0 || event.owner != 0 || event.price != 0) {
+                    idKeys_ = {event.planeId, event.time, event.owner, static_cast<uint32_t>(event.price)};
+                    hasIdKeys_ = true;
+                }
+                continue;
+            }
+            if (event.type == BookingLedger::NameEvent) {
+                if (event.id >= sessionNames.size()) {
+                    sessionNames.resize(event.id + 1, kNoPlane);
+                }
+                sessionNames[event.id] = names_.intern(string(data.data() + offset, event.length));
+                offset += event.length;
+                continue;
+            }
+            if (event.planeId >= sessionNames.size() || event.time >= sessionNames.size() || event.owner >= sessionNames.size()) {
+                continue;
+            }
+            event.planeId = sessionNames[event.planeId];
+            event.time = sessionNames[event.time];
+            event.owner = sessionNames[event.owner];
+            if (event.planeId == kNoPlane || event.time == kNoPlane || event.owner == kNoPlane) {
+                continue;
+            }
+            if (event.type == BookingLedger::HoldEvent || event.type == BookingLedger::HoldReleaseEvent) {
+                event.id = session_ << 40 | event.id;
+            }
+            if (event.planeId >= planeIndex_.size()) {
+                planeIndex_.resize(event.planeId + 1, kNoPlane);
+            }
+            if (planeIndex_[event.planeId] == kNoPlane) {
+                planeIndex_[event.planeId] = static_cast<uint32_t>(planes_.size());
+                planes_.emplace_back();
+                planes_.back().planeId = event.planeId;
+            }
+            if (event.type == BookingLedger::BookEvent) {
+                resolveRoute(event.planeId, event.time);
+            }
+            planes_[planeIndex_[event.planeId]].events.emplace_back(session_, event);
+        }
+        validBytes_ = offset;
+        return eventCount;
+    }
+
+    void resolveRoute(uint32_t planeId, uint32_t time) {
+        uint64_t key = uint64_t(planeId) << 32 | time;
+        if (routes_.count(key)) {
+            return;
+        }
+        json details = flightSchedule_.getFlightDetails(names_.name(planeId), names_.name(time));
+        Route route = {};
+        route.departureCity = names_.intern(details.is_null() ? "" : details["departure_city"].get<string>());
+        route.destinationCity = names_.intern(details.is_null() ? "" : details["destination_city"].get<string>());
+        route.weekDay = names_.intern(details.is_null() ? "" : details["week_day"].get<string>());
+        parseDeparture(names_.name(route.weekDay), names_.name(time), route.departure);
+        routes_[key] = route;
+    }
+
+    void replayPlane(PlaneState& plane) {
+        plane.seats.assign(kSeatWords, 0);
+        for (SeatCode seat : airplane_.takenSeats(names_.name(plane.planeId))) {
+            claim(plane, seat);
+        }
+        uint64_t session = 0;
+        for (const auto& entry : plane.events) {
+            if (entry.first != session) {
+                expireHolds(plane);
+                session = entry.first;
+            }
+            const BookingLedger::Event& event = entry.second;
+            if (event.type == BookingLedger::BookEvent) {
+                claim(plane, event.seat);
+                const Route& route = routes_.find(uint64_t(event.planeId) << 32 | event.time)->second;
+                TicketRecord record = {};
+                record.planeId = event.planeId;
+                record.departureCity = route.departureCity;
+                record.destinationCity = route.destinationCity;
+                record.weekDay = route.weekDay;
+                record.time = event.time;
+                record.seat = event.seat;
+                record.zone = event.zone;
+                record.price = event.price;
+                record.owner = event.owner;
+                record.departure = route.departure;
+                plane.tickets.insert(event.id, record);
+            } else if (event.type == BookingLedger::RefundEvent) {
+                if (plane.tickets.erase(event.id)) {
+                    release(plane, event.seat);
+                }
+            } else if (event.type == BookingLedger::HoldEvent) {
+                claim(plane, event.seat);
+                plane.holds[event.id] = event.seat;
+            } else if (event.type == BookingLedger::HoldReleaseEvent) {
+                if (plane.holds.erase(event.id)) {
+                    release(plane, event.seat);
+                }
+            }
+        }
+        if (session < session_) {
+            expireHolds(plane);
+        }
+    }
+
+    static void expireHolds(PlaneState& plane) {
+        for (const auto& hold : plane.holds) {
+            release(plane, hold.second);
+        }
+        plane.holds.clear();
+    }
+
+    static void claim(PlaneState& plane, SeatCode seat) {
+        uint64_t& word = plane.seats[seat / 64];
+        uint64_t bit = uint64_t(1) << (seat % 64);
+        if (word & bit) {
+            plane.conflicts++;
+            return;
+        }
+        word |= bit;
+        plane.occupied++;
+    }
+
+    static void release(PlaneState& plane, SeatCode seat) {
+        uint64_t& word = plane.seats[seat / 64];
+        uint64_t bit = uint64_t(1) << (seat % 64);
+        if (word & bit) {
+            word ^= bit;
+            plane.occupied--;
+        }
+    }
+
+    const FlightSchedule& flightSchedule_;
+    const Airplane& airplane_;
+    StringPool names_;
+    unordered_map<uint64_t, Route> routes_;
+    vector<uint32_t> planeIndex_;
+    vector<PlaneState> planes_;
+    uint64_t session_ = 0;
+    TicketIdGenerator::Keys idKeys_ = {};
+    bool hasIdKeys_ = false;
+    size_t eventCount_ = 0;
+    size_t ledgerBytes_ = 0;
+    size_t validBytes_ = 0;
+    bool corrupt_ = false;
+};
+
+struct ItinerarySegment {
+    string planeId;
+    string time;
+    string seat;
+};
+
+class Ticket {
+public:
+    Ticket(FlightSchedule& flightSchedule, Airplane& airplane, AvailabilityHeatmap& heatmap, BookingLedger& ledger, const LedgerReplay& history) : flightSchedule_(flightSchedule), airplane_(airplane), heatmap_(heatmap), ledger_(ledger), holdExpiry_(nowSeconds()), ticketIds_(history.sessions() + 1, idKeys(history)), requests_(kRequestCacheCapacity, kRequestTtlSeconds) {
+        ledger_.beginSession(history.sessions() + 1, ticketIds_.keys());
+        restore(history);
+    }
+
+    string bookSeat(const string& planeId, const string& time, const string& seatName, const string& username, const string& requestKey = "") {
+        SeatCode seat = parseSeat(seatName);
+        if (seat == kInvalidSeat) {
+            return "Invalid seat";
+        }
+        string cacheKey;
+        uint64_t ticketId;
+        if (!requestKey.empty()) {
+            cacheKey = username + '\n' + requestKey;
+            if (requests_.claim(cacheKey, nowSeconds(), ticketId)) {
+                return TicketIdGenerator::format(ticketId);
+            }
+        }
+        Reservation reservation = reserve(planeId, time, seat);
+        if (!reservation.error.empty()) {
+            if (!cacheKey.empty()) {
+                requests_.abandon(cacheKey);
+            }
+            return reservation.error;
+        }
+        ticketId = issueTicketId(reservation, planeId, time, username);
+        if (ticketId == 0) {
+            if (!cacheKey.empty()) {
+                requests_.abandon(cacheKey);
+            }
+            return kNotRecorded;
+        }
+        if (!cacheKey.empty()) {
+            requests_.complete(cacheKey, ticketId, nowSeconds());
+        }
+        return TicketIdGenerator::format(ticketId);
+    }
+
+    string bookBestSeat(const string& planeId, const string& time, const string& zone, SeatPreference preference, const string& username) {
+        return issueTicket(reserveBest(planeId, time, zone, preference), planeId, time, username);
+    }
+
+    string bookGroup(const string& planeId, const string& time, const string& zone, int count, const string& username) {
+        Reservation flight = findFlight(planeId, time);
+        if (!flight.error.empty()) {
+            return flight.error;
+        }
+        vector<SeatReservation> seats = airplane_.reserveGroup(planeId, zone, count);
+        if (seats.empty()) {
+            return "No adjacent seats available";
+        }
+        string ticketIds;
+        for (const SeatReservation& seat : seats) {
+            Reservation reservation = flight;
+            completeReservation(reservation, planeId, seat, "");
+            if (!ticketIds.empty()) {
+                ticketIds += ", ";
+            }
+            ticketIds += issueTicket(reservation, planeId, time, username);
+        }
+        return ticketIds;
+    }
+
+    string bookItinerary(const vector<ItinerarySegment>& segments, const string& username) {
+        if (segments.empty()) {
+            return "Empty itinerary";
+        }
+        vector<Reservation> reservations;
+        reservations.reserve(segments.size());
+        for (size_t i = 0; i < segments.size(); i++) {
+            const ItinerarySegment& segment = segments[i];
+            SeatCode seat = parseSeat(segment.seat);
+            Reservation reservation;
+            if (seat == kInvalidSeat) {
+                reservation.error = "Invalid seat";
+            } else {
+                reservation = reserve(segment.planeId, segment.time, seat);
+            }
+            if (!reservation.error.empty()) {
+                for (size_t j = 0; j < reservations.size(); j++) {
+                    releaseSeat(segments[j].planeId, reservations[j].zone, reservations[j].seat, reservations[j].price);
+                }
+                return "Segment " + to_string(i + 1) + ": " + reservation.error;
+            }
+            reservations.push_back(reservation);
+        }
+        string ticketIds;
+        for (size_t i = 0; i < segments.size(); i++) {
+            if (!ticketIds.empty()) {
+                ticketIds += ", ";
+            }
+            ticketIds += issueTicket(reservations[i], segments[i].planeId, segments[i].time, username);
+        }
+        return ticketIds;
+    }
+
+    string holdSeat(const string& planeId, const string& time, const string& seatName, const string& username, int ttlSeconds) {
+        expireHolds();
+        SeatCode seat = parseSeat(seatName);
+        if (seat == kInvalidSeat) {
+            return "Invalid seat";
+        }
+        Reservation reservation = reserve(planeId, time, seat);
+        if (!reservation.error.empty()) {
+            return reservation.error;
+        }
+        uint64_t holdId = nextHoldId_++;
+        Hold hold = {reservation, planeId, time, username};
+        if (!recordHold(BookingLedger::HoldEvent, holdId, hold)) {
+            airplane_.releaseSeat(planeId, reservation.zone, reservation.seat);
+            heatmap_.seatRefunded(planeId);
+            return "Hold could not be recorded";
+        }
+        lock_guard<mutex> lock(holdsLock_);
+        holds_[holdId] = hold;
+        holdExpiry_.schedule(holdId, nowSeconds() + max(ttlSeconds, 1));
+        return to_string(holdId);
+    }
+
+    string confirmHold(const string& holdId) {
+        expireHolds();
+        uint64_t id;
+        Hold hold;
+        {
+            lock_guard<mutex> lock(holdsLock_);
+            auto it = holds_.end();
+            if (!holdId.empty() && all_of(holdId.begin(), holdId.end(), ::isdigit) && holdId.size() < 20) {
+                it = holds_.find(stoull(holdId));
+            }
+            if (it == holds_.end()) {
+                return "Hold not found";
+            }
+            id = it->first;
+            hold = it->second;
+            holds_.erase(it);
+        }
+        if (!recordHold(BookingLedger::HoldReleaseEvent, id, hold)) {
+            releaseSeat(hold.planeId, hold.reservation.zone, hold.reservation.seat, hold.reservation.price);
+            return "Hold confirmation could not be recorded";
+        }
+        return issueTicket(hold.reservation, hold.planeId, hold.time, hold.username);
+    }
+
+    void expireHolds() {
+        vector<pair<uint64_t, Hold>> expiredHolds;
+        {
+            lock_guard<mutex> lock(holdsLock_);
+            vector<uint64_t> expired;
+            holdExpiry_.advance(nowSeconds(), expired);
+            for (uint64_t holdId : expired) {
+                auto it = holds_.find(holdId);
+                if (it != holds_.end()) {
+                    expiredHolds.push_back(*it);
+                    holds_.erase(it);
+                }
+            }
+        }
+        for (const auto& [holdId, hold] : expiredHolds) {
+            recordHold(BookingLedger::HoldReleaseEvent, holdId, hold);
+            releaseSeat(hold.planeId, hold.reservation.zone, hold.reservation.seat, hold.reservation.price);
+        }
+    }
+
+    void setWaitlistCapacity(const string& planeId, const string& time, int capacity) {
+        PlaneStripe& stripe = stripeFor(planeId);
+        lock_guard<mutex> lock(stripe.lock);
+        stripe.waitlistCapacities[{planeId, time}] = max(capacity, 0);
+    }
+
+    string joinWaitlist(const string& planeId, const string& time, const string& zone, int fare, const string& username) {
+        expireHolds();
+        uint8_t zoneIndex;
+        if (!Airplane::findZoneIndex(zone, zoneIndex)) {
+            return "Invalid zone";
+        }
+        PlaneStripe& stripe = stripeFor(planeId);
+        unique_lock<mutex> lock(stripe.lock);
+        Reservation reservation = reserveBest(planeId, time, zone, AnySeat);
+        if (reservation.error.empty()) {
+            lock.unlock();
+            return issueTicket(reservation, planeId, time, username);
+        }
+        if (reservation.flightDetails.is_null()) {
+            return reservation.error;
+        }
+        auto capacity = stripe.waitlistCapacities.find({planeId, time});
+        int& waitlisted = stripe.waitlisted[{planeId, time}];
+        if (capacity == stripe.waitlistCapacities.end() || waitlisted >= capacity->second) {
+            return "Flight is full";
+        }
+        stripe.waitlists[{planeId, zoneIndex}].push({fare, nextWaitlistSequence_++, time, username, reservation.flightDetails});
+        waitlisted++;
+        return "Waitlisted";
+    }
+
+    string ticketInfo(const string& ticketId, bool username) {
+        string result;
+        if (!writeTicketInfo(ticketId, username, result)) {
+            return "Ticket not found";
+        }
+        return result;
+    }
+
+    bool writeTicketInfo(const string& ticketId, bool username, string& out) {
+        uint64_t id = TicketIdGenerator::parse(ticketId);
+        TicketRecord record;
+        if (!findTicket(id, record)) {
+            return false;
+        }
+        appendTicket(out, id, record, username);
+        return true;
+    }
+
+    string userTickets(const string& username) {
+        string result;
+        if (!writeUserTickets(username, result)) {
+            return "No tickets found for the user";
+        }
+        return result;
+    }
+
+    bool writeUserTickets(const string& username, string& out) {
+        bool appended = false;
+        visitUserTickets(username, kFirstUserTicket, kLastUserTicket, [&](uint64_t id, const TicketRecord& record) {
+            if (appended) {
+                out += "\n\n";
+            } else {
+                out += "Tickets bought by ";
+                out += username;
+                out += ":\n\n";
+            }
+            appendTicket(out, id, record, false);
+            appended = true;
+        });
+        if (appended) {
+            out += "\n";
+        }
+        return appended;
+    }
+
+    bool writeUserTicketsPage(const string& username, const string& cursor, size_t pageSize, string& out, string& nextCursor) {
+        nextCursor.clear();
+        UserTicket position = kFirstUserTicket;
+        vector<UserTicket> ticketIds;
+        pageSize = max<size_t>(pageSize, 1);
+        if ((!cursor.empty() && !parseCursor(cursor, position)) || !copyUserTickets(username, position, kLastUserTicket, pageSize + 1, ticketIds)) {
+            return false;
+        }
+        if (ticketIds.size() > pageSize) {
+            ticketIds.pop_back();
+            nextCursor = to_string(ticketIds.back().first) + "-" + TicketIdGenerator::format(ticketIds.back().second);
+        }
+        appendTickets(out, ticketIds);
+        return true;
+    }
+
+    string userTicketsBetween(const string& username, const string& fromDay, const string& fromTime, const string& toDay, const string& toTime) {
+        uint32_t from, to;
+        if (!parseDeparture(fromDay, fromTime, from) || !parseDeparture(toDay, toTime, to) || from > to) {
+            return "Invalid departure range";
+        }
+        string out;
+        bool found = visitUserTickets(username, {from, 0}, {to, ~uint64_t(0)}, [this, &out](uint64_t id, const TicketRecord& record) {
+            if (!out.empty()) {
+                out += "\n\n";
+            }
+            appendTicket(out, id, record, false);
+        });
+        if (!found) {
+            return "No tickets found for the user";
+        }
+        if (out.empty()) {
+            return "No tickets found in the range";
+        }
+        return out;
+    }
+
+    bool streamUserTickets(const string& username, ostream& out) {
+        string buffer;
+        bool appended = false;
+        visitUserTickets(username, kFirstUserTicket, kLastUserTicket, [&](uint64_t id, const TicketRecord& record) {
+            if (!appended) {
+                out << "Tickets bought by " << username << ":\n\n";
+            }
+            buffer.assign(appended ? "\n\n" : "");
+            appendTicket(buffer, id, record, false);
+            out << buffer;
+            appended = true;
+        });
+        if (appended) {
+            out << "\n";
+        }
+        return appended;
+    }
+
+    string manifest(const string& planeId, const string& weekDay, const string& time) {
+        uint32_t plane, day, departure;
+        if (!names_.find(planeId, plane) || !names_.find(weekDay, day) || !names_.find(time, departure)) {
+            return "No tickets found for the flight";
+        }
+        Manifest passengers;
+        {
+            PlaneStripe& stripe = stripeFor(planeId);
+            lock_guard<mutex> lock(stripe.lock);
+            auto it = stripe.manifests.find(make_tuple(plane, day, departure));
+            if (it != stripe.manifests.end()) {
+                passengers = it->second;
+            }
+        }
+        if (passengers.empty()) {
+            return "No tickets found for the flight";
+        }
+        string out = "Manifest for " + planeId + ", " + weekDay + " " + time + ":";
+        char buffer[16];
+        for (const auto& passenger : passengers) {
+            TicketRecord record;
+            if (!findTicket(passenger.second, record)) {
+                continue;
+            }
+            out += "\n";
+            out.append(buffer, writeSeat(buffer, passenger.first));
+            out += " - ";
+            out += names_.name(record.owner);
+            out += ", ticket ";
+            out.append(buffer, TicketIdGenerator::write(buffer, passenger.second));
+        }
+        return out;
+    }
+
+    string refund(const string& ticketId) {
+        uint64_t id = TicketIdGenerator::parse(ticketId);
+        TicketRecord record;
+        if (takeTicket(id, record)) {
+            const string& planeId = names_.name(record.planeId);
+            if (!ledger_.record(BookingLedger::RefundEvent, id, record, names_)) {
+                storeTicket(id, record);
+                return "Refund could not be recorded";
+            }
+            removeManifestEntry(planeId, id, record);
+            removeUserTicket(id, record);
+            string promotion = releaseSeat(planeId, record.zone, record.seat, record.price);
+            return "Confirmed refund of " + to_string(record.price) + "$ for " + names_.name(record.owner) + promotion;
+        } else {
+            return "Ticket not found";
+        }
+    }
+private:
+    static constexpr size_t kRequestCacheCapacity = 65536;
+    static constexpr uint64_t kRequestTtlSeconds = 600;
+    static constexpr size_t kPlaneStripes = 64;
+    static constexpr size_t kTicketShards = 64;
+    static constexpr size_t kUserTicketChunk = 256;
+    static constexpr const char* kNotRecorded = "Booking could not be recorded";
+
+    using UserTicket = pair<uint32_t, uint64_t>;
+    using UserTickets = set<UserTicket>;
+    using Manifest = vector<pair<SeatCode, uint64_t>>;
+
+    static constexpr UserTicket kFirstUserTicket = {0, 0};
+    static constexpr UserTicket kLastUserTicket = {~uint32_t(0), ~uint64_t(0)};
+
+    struct Reservation {
+        string error;
+        SeatCode seat = kInvalidSeat;
+        uint8_t zone = 0;
+        int price = 0;
+        json flightDetails;
+    };
+
+    string issueTicket(const Reservation& reservation, const string& planeId, const string& time, const string& username) {
+        if (!reservation.error.empty()) {
+            return reservation.error;
+        }
+        uint64_t id = issueTicketId(reservation, planeId, time, username);
+        return id != 0 ? TicketIdGenerator::format(id) : kNotRecorded;
+    }
+
+    uint64_t issueTicketId(const Reservation& reservation, const string& planeId, const string& time, const string& username) {
+        TicketRecord record;
+        record.planeId = names_.intern(planeId);
+        record.departureCity = names_.intern(reservation.flightDetails["departure_city"]);
+        record.destinationCity = names_.intern(reservation.flightDetails["destination_city"]);
+        record.weekDay = names_.intern(reservation.flightDetails["week_day"]);
+        record.time = names_.intern(time);
+        record.seat = reservation.seat;
+        record.zone = reservation.zone;
+        record.price = reservation.price;
+        record.owner = names_.intern(username);
+        record.departure = 0;
+        parseDeparture(names_.name(record.weekDay), time, record.departure);
+        uint64_t id = ticketIds_.next();
+        if (!ledger_.record(BookingLedger::BookEvent, id, record, names_)) {
+            airplane_.releaseSeat(planeId, reservation.zone, reservation.seat);
+            heatmap_.seatRefunded(planeId);
+            return 0;
+        }
+        if (!storeTicket(id, record)) {
+            throw logic_error("Ticket ID " + TicketIdGenerator::format(id) + " was issued twice");
+        }
+        addUserTicket(id, record);
+        addManifestEntry(planeId, id, record);
+        return id;
+    }
+
+    Reservation reserve(const string& planeId, const string& time, SeatCode seat) {
+        Reservation reservation = findFlight(planeId, time);
+        if (reservation.error.empty()) {
+            completeReservation(reservation, planeId, airplane_.reserveSeat(planeId, seat), "Seat is taken");
+        }
+        return reservation;
+    }
+
+    Reservation reserveBest(const string& planeId, const string& time, const string& zone, SeatPreference preference) {
+        Reservation reservation = findFlight(planeId, time);
+        if (reservation.error.empty()) {
+            completeReservation(reservation, planeId, airplane_.reserveBestSeat(planeId, zone, preference), "No seats available");
+        }
+        return reservation;
+    }
+
+    Reservation findFlight(const string& planeId, const string& time) {
+        Reservation reservation;
+        reservation.flightDetails = flightSchedule_.getFlightDetails(planeId, time);
+        if (reservation.flightDetails.is_null()) {
+            reservation.error = "Flight not found";
+        }
+        return reservation;
+    }
+
+    void completeReservation(Reservation& reservation, const string& planeId, const SeatReservation& seatReservation, const string& error) {
+        if (seatReservation.price == 0) {
+            reservation.error = error;
+            return;
+        }
+        reservation.seat = seatReservation.seat;
+        reservation.zone = seatReservation.zone;
+        reservation.price = seatReservation.price;
+        heatmap_.seatBooked(planeId);
+    }
+
+    struct WaitlistEntry {
+        int fare;
+        uint64_t sequence;
+        string time;
+        string username;
+        json flightDetails;
+    };
+
+    struct WaitlistOrder {
+        bool operator()(const WaitlistEntry& entry1, const WaitlistEntry& entry2) const {
+            if (entry1.fare != entry2.fare) {
+                return entry1.fare < entry2.fare;
+            }
+            return entry1.sequence > entry2.sequence;
+        }
+    };
+
+    struct PlaneStripe {
+        mutex lock;
+        map<pair<string, string>, int> waitlistCapacities;
+        map<pair<string, string>, int> waitlisted;
+        map<pair<string, uint8_t>, priority_queue<WaitlistEntry, vector<WaitlistEntry>, WaitlistOrder>> waitlists;
+        map<tuple<uint32_t, uint32_t, uint32_t>, Manifest> manifests;
+    };
+
+    struct TicketShard {
+        mutex lock;
+        TicketStore tickets;
+    };
+
+    struct UserShard {
+        mutex lock;
+        unordered_map<uint32_t, UserTickets> tickets;
+    };
+
+    PlaneStripe& stripeFor(const string& planeId) {
+        return planeStripes_[hash<string>()(planeId) % kPlaneStripes];
+    }
+
+    TicketShard& ticketShardFor(uint64_t id) {
+        return ticketShards_[id % kTicketShards];
+    }
+
+    UserShard& userShardFor(uint32_t owner) {
+        return userShards_[owner % kTicketShards];
+    }
+
+    string releaseSeat(const string& planeId, uint8_t zone, SeatCode seat, int price) {
+        PlaneStripe& stripe = stripeFor(planeId);
+        unique_lock<mutex> lock(stripe.lock);
+        auto it = stripe.waitlists.find({planeId, zone});
+        if (it == stripe.waitlists.end()) {
+            airplane_.releaseSeat(planeId, zone, seat);
+            heatmap_.seatRefunded(planeId);
+            return "";
+        }
+        WaitlistEntry entry = it->second.top();
+        it->second.pop();
+        if (it->second.empty()) {
+            stripe.waitlists.erase(it);
+        }
+        stripe.waitlisted[{planeId, entry.time}]--;
+        lock.unlock();
+        Reservation reservation;
+        reservation.seat = seat;
+        reservation.zone = zone;
+        reservation.price = price;
+        reservation.flightDetails = entry.flightDetails;
+        string ticketId = issueTicket(reservation, planeId, entry.time, entry.username);
+        if (ticketId == kNotRecorded) {
+            return "; passing the seat to " + entry.username + " from the waitlist could not be recorded";
+        }
+        return "; seat passed to " + entry.username + " from the waitlist, ticket " + ticketId;
+    }
+
+    struct Hold {
+        Reservation reservation;
+        string planeId;
+        string time;
+        string username;
+    };
+
+    bool recordHold(BookingLedger::EventType type, uint64_t holdId, const Hold& hold) {
+        TicketRecord record = {};
+        record.planeId = names_.intern(hold.planeId);
+        record.time = names_.intern(hold.time);
+        record.owner = names_.intern(hold.username);
+        record.seat = hold.reservation.seat;
+        record.zone = hold.reservation.zone;
+        record.price = hold.reservation.price;
+        return ledger_.record(type, holdId, record, names_);
+    }
+
+    bool storeTicket(uint64_t id, const TicketRecord& record) {
+        TicketShard& shard = ticketShardFor(id);
+        lock_guard<mutex> lock(shard.lock);
+        return shard.tickets.insert(id, record);
+    }
+
+    bool findTicket(uint64_t id, TicketRecord& record) {
+        TicketShard& shard = ticketShardFor(id);
+        lock_guard<mutex> lock(shard.lock);
+        const TicketRecord* stored = shard.tickets.find(id);
+        if (!stored) {
+            return false;
+        }
+        record = *stored;
+        return true;
+    }
+
+    bool takeTicket(uint64_t id, TicketRecord& record) {
+        TicketShard& shard = ticketShardFor(id);
+        lock_guard<mutex> lock(shard.lock);
+        const TicketRecord* stored = shard.tickets.find(id);
+        if (!stored) {
+            return false;
+        }
+        record = *stored;
+        shard.tickets.erase(id);
+        return true;
+    }
+
+    void addUserTicket(uint64_t id, const TicketRecord& record) {
+        UserShard& shard = userShardFor(record.owner);
+        lock_guard<mutex> lock(shard.lock);
+        shard.tickets[record.owner].emplace(record.departure, id);
+    }
+
+    void removeUserTicket(uint64_t id, const TicketRecord& record) {
+        UserShard& shard = userShardFor(record.owner);
+        lock_guard<mutex> lock(shard.lock);
+        auto it = shard.tickets.find(record.owner);
+        UserTickets& ownerTickets = it->second;
+        ownerTickets.erase(make_pair(record.departure, id));
+        if (ownerTickets.empty()) {
+            shard.tickets.erase(it);
+        }
+    }
+
+    bool copyUserTickets(const string& username, const UserTicket& after, const UserTicket& last, size_t limit, vector<UserTicket>& out) {
+        uint32_t owner;
+        if (!names_.find(username, owner)) {
+            return false;
+        }
+        UserShard& shard = userShardFor(owner);
+        lock_guard<mutex> lock(shard.lock);
+        auto it = shard.tickets.find(owner);
+        if (it == shard.tickets.end()) {
+            return false;
+        }
+        auto end = it->second.upper_bound(last);
+        for (auto ticket = it->second.upper_bound(after); ticket != end && out.size() < limit; ++ticket) {
+            out.push_back(*ticket);
+        }
+        return true;
+    }
+
+    template <typename Visitor>
+    bool visitUserTickets(const string& username, UserTicket after, const UserTicket& last, Visitor visit) {
+        vector<UserTicket> chunk;
+        chunk.reserve(kUserTicketChunk);
+        if (!copyUserTickets(username, after, last, kUserTicketChunk, chunk)) {
+            return false;
+        }
+        while (!chunk.empty()) {
+            for (const UserTicket& ticketId : chunk) {
+                TicketRecord record;
+                if (findTicket(ticketId.second, record)) {
+                    visit(ticketId.second, record);
+                }
+            }
+            if (chunk.size() < kUserTicketChunk) {
+                break;
+            }
+            after = chunk.back();
+            chunk.clear();
+            copyUserTickets(username, after, last, kUserTicketChunk, chunk);
+        }
+        return true;
+    }
+
+    static bool parseCursor(const string& cursor, UserTicket& position) {
+        auto result = from_chars(cursor.data(), cursor.data() + cursor.size(), position.first);
+        if (result.ec != errc() || result.ptr == cursor.data() + cursor.size() || *result.ptr != '-') {
+            return false;
+        }
+        position.second = TicketIdGenerator::parse(cursor.substr(result.ptr - cursor.data() + 1));
+        return position.second != 0;
+    }
+
+    void appendTickets(string& out, const vector<UserTicket>& ticketIds) {
+        bool appended = false;
+        for (const UserTicket& ticketId : ticketIds) {
+            TicketRecord record;
+            if (!findTicket(ticketId.second, record)) {
+                continue;
+            }
+            if (appended) {
+                out += "\n\n";
+            }
+            appendTicket(out, ticketId.second, record, false);
+            appended = true;
+        }
+        if (appended) {
+            out += "\n";
+        }
+    }
+
+    void addManifestEntry(const string& planeId, uint64_t id, const TicketRecord& record) {
+        PlaneStripe& stripe = stripeFor(planeId);
+        lock_guard<mutex> lock(stripe.lock);
+        Manifest& passengers = stripe.manifests[make_tuple(record.planeId, record.weekDay, record.time)];
+        passengers.insert(upper_bound(passengers.begin(), passengers.end(), make_pair(record.seat, id)), make_pair(record.seat, id));
+    }
+
+    void removeManifestEntry(const string& planeId, uint64_t id, const TicketRecord& record) {
+        PlaneStripe& stripe = stripeFor(planeId);
+        lock_guard<mutex> lock(stripe.lock);
+        auto it = stripe.manifests.find(make_tuple(record.planeId, record.weekDay, record.time));
+        if (it == stripe.manifests.end()) {
+            return;
+        }
+        Manifest& passengers = it->second;
+        auto passenger = lower_bound(passengers.begin(), passengers.end(), make_pair(record.seat, id));
+        if (passenger != passengers.end() && passenger->second == id) {
+            passengers.erase(passenger);
+        }
+        if (passengers.empty()) {
+            stripe.manifests.erase(it);
+        }
+    }
+
+    void appendTicket(string& out, uint64_t id, const TicketRecord& record, bool username) const {
+        char buffer[32];
+        out += "Information about ticket ";
+        out.append(buffer, TicketIdGenerator::write(buffer, id));
+        if (username) {
+            out += ", bought by ";
+            out += names_.name(record.owner);
+        }
+        out += ":\nRoute: ";
+        out += names_.name(record.departureCity);
+        out += " - ";
+        out += names_.name(record.destinationCity);
+        out += ";\nDate: ";
+        out += names_.name(record.weekDay);
+        out += ", ";
+        out += names_.name(record.time);
+        out += ";\nSeat Info: PlaneId - ";
+        out += names_.name(record.planeId);
+        out += ", Place - ";
+        out.append(buffer, writeSeat(buffer, record.seat));
+        out += ", Price - ";
+        out.append(buffer, to_chars(buffer, buffer + sizeof(buffer), record.price).ptr);
+        out += "$.";
+    }
+
+    static TicketIdGenerator::Keys idKeys(const LedgerReplay& history) {
+        TicketIdGenerator::Keys keys;
+        return history.idKeys(keys) ? keys : TicketIdGenerator::randomKeys();
+    }
+
+    void restore(const LedgerReplay& replay) {
+        replay.forEachTicket([this](uint64_t id, const TicketRecord& stored, const StringPool& names) {
+            const string& planeId = names.name(stored.planeId);
+            TicketRecord record = stored;
+            record.planeId = names_.intern(planeId);
+            record.departureCity = names_.intern(names.name(stored.departureCity));
+            record.destinationCity = names_.intern(names.name(stored.destinationCity));
+            record.weekDay = names_.intern(names.name(stored.weekDay));
+            record.time = names_.intern(names.name(stored.time));
+            record.owner = names_.intern(names.name(stored.owner));
+            if (!storeTicket(id, record)) {
+                return;
+            }
+            if (airplane_.reserveSeat(planeId, record.seat).price != 0) {
+                heatmap_.seatBooked(planeId);
+            }
+            addUserTicket(id, record);
+            addManifestEntry(planeId, id, record);
+        });
+    }
+
+    static uint64_t nowSeconds() {
+        return chrono::duration_cast<chrono::seconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    FlightSchedule& flightSchedule_;
+    Airplane& airplane_;
+    AvailabilityHeatmap& heatmap_;
+    BookingLedger& ledger_;
+    mutex holdsLock_;
+    unordered_map<uint64_t, Hold> holds_;
+    atomic<uint64_t> nextHoldId_{1};
+    TimingWheel holdExpiry_;
+    atomic<uint64_t> nextWaitlistSequence_{0};
+    StringPool names_;
+    TicketIdGenerator ticketIds_;
+    PlaneStripe planeStripes_[kPlaneStripes];
+    TicketShard ticketShards_[kTicketShards];
+    UserShard userShards_[kTicketShards];
+    RequestCache requests_;
+};
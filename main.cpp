@@ -1,259 +1,4 @@
-#include <iostream>
-#include <fstream>
-#include <string>
-#include <nlohmann/json.hpp>
-#include <random>
-
-using namespace std;
-using json = nlohmann::json;
-
-class FileHandler {
-public:
-    FileHandler(const string& filename) : filename_(filename) {}
-
-    json loadJsonData() {
-        ifstream file(filename_);
-        json jsonData;
-        file >> jsonData;
-        file.close();
-        return jsonData;
-    }
-
-    void writeJsonData(const json& data) {
-        ofstream file(filename_);
-        file << data.dump(2);
-        file.close();
-    }
-private:
-    string filename_;
-};
-
-class FlightSchedule {
-public:
-    FlightSchedule(FileHandler& flightDataHandler) : flightDataHandler_(flightDataHandler) {}
-
-    json checkPlanes(const string& city1, const string& city2) {
-        json jsonData = flightDataHandler_.loadJsonData();
-        return jsonData[city1][city2];
-    }
-
-    json getFlightDetails(const string& planeId, const string& time) {
-        json jsonData = flightDataHandler_.loadJsonData();
-        json result;
-        for (const auto& departureCity : jsonData.items()) {
-            const string& departure = departureCity.key();
-            for (const auto& destinationCity : departureCity.value().items()) {
-                const string& destination = destinationCity.key();
-                for (const auto& day : destinationCity.value().items()) {
-                    const string& weekDay = day.key();
-                    for (const auto& flight : day.value().items()) {
-                        if (flight.key() == planeId && flight.value() == time) {
-                            result["week_day"] = weekDay;
-                            result["departure_city"] = departure;
-                            result["destination_city"] = destination;
-                        }
-                    }
-                }
-            }
-        }
-        return result;
-    }
-private:
-    FileHandler flightDataHandler_;
-};
-
-class Airplane {
-public:
-    Airplane(FileHandler& planeDataHandler) : planeDataHandler_(planeDataHandler) {}
-
-    json checkSeats(const string& planeId) {
-        json result;
-        json planeInfo = planeDataHandler_.loadJsonData();
-        result["free_seats"] = planeInfo[planeId]["free_seats"];
-        for (const auto& zone : {"front", "center", "back"}) {
-            json zoneInfo;
-            zoneInfo["free_seats"] = planeInfo[planeId][zone]["free_seats"];
-            zoneInfo["price"] = planeInfo[planeId][zone]["price"];
-            result[zone] = zoneInfo;
-        }
-        return result;
-    }
-
-    int getPrice(const string& planeId, const string& seat) {
-        json planeInfo = planeDataHandler_.loadJsonData();
-        int price = 0;
-        for (const auto& zone : {"front", "center", "back"}) {
-            for (const auto& freeSeat : planeInfo[planeId][zone]["free_seats"]) {
-                if (freeSeat == seat) {
-                    price = planeInfo[planeId][zone]["price"];
-                }
-            }
-        }
-        return price;
-    }
-
-    void updateFile(const string& planeId, const string& seat) {
-        json planeInfo = planeDataHandler_.loadJsonData();
-        for (const auto& zone : {"front", "center", "back"}) {
-            json& freeSeats = planeInfo[planeId][zone]["free_seats"];
-            auto it = find(freeSeats.begin(), freeSeats.end(), seat);
-            if (it != freeSeats.end()) {
-                freeSeats.erase(it);
-                planeInfo[planeId]["free_seats"] = planeInfo[planeId]["free_seats"].get<int>() - 1;
-                planeDataHandler_.writeJsonData(planeInfo);
-                break;
-            }
-        }
-    }
-
-    string findZoneBySeat(const string& planeId, const string& seat) {
-        json planeInfo = planeDataHandler_.loadJsonData();
-        for (const auto& zone : {"front", "center", "back"}) {
-            json& freeSeats = planeInfo[planeId][zone]["free_seats"];
-            if (find(freeSeats.begin(), freeSeats.end(), seat) != freeSeats.end()) {
-                return zone;
-            }
-        }
-        return "Seat not found";
-    }
-
-    static bool seatComparator(const string& seat1, const string& seat2) {
-        int num1 = stoi(seat1.substr(0, seat1.size() - 1));
-        int num2 = stoi(seat2.substr(0, seat2.size() - 1));
-        return num1 < num2;
-    }
-
-    void refundUpdateFile(const string& planeId, const string& zone, const string& seat) {
-        json planeInfo = planeDataHandler_.loadJsonData();
-        json& freeSeats = planeInfo[planeId][zone]["free_seats"];
-        freeSeats.push_back(seat);
-        sort(freeSeats.begin(), freeSeats.end(), seatComparator);
-        planeInfo[planeId]["free_seats"] = planeInfo[planeId]["free_seats"].get<int>() + 1;
-        planeDataHandler_.writeJsonData(planeInfo);
-    }
-
-private:
-    FileHandler planeDataHandler_;
-};
-
-class Ticket {
-public:
-    Ticket(FlightSchedule& flightSchedule, Airplane& airplane) : flightSchedule_(flightSchedule), airplane_(airplane) {}
-
-    static int generateRandomTicketId() {
-        random_device rd;
-        mt19937 gen(rd());
-        uniform_int_distribution<int> dis(10000, 99999);
-        return dis(gen);
-    }
-
-    string bookSeat(const string& planeId, const string& time, const string& seat, const string& username) {
-        int price = airplane_.getPrice(planeId, seat);
-        if (price != 0) {
-            json flightDetails = flightSchedule_.getFlightDetails(planeId, time);
-            json seatsInfo = airplane_.checkSeats(planeId);
-            string zone = airplane_.findZoneBySeat(planeId, seat);
-            seatsByZone_[zone].push_back(seat);
-            airplane_.updateFile(planeId, seat);
-            string ticketId;
-            while (true) {
-                ticketId = to_string(generateRandomTicketId());
-                auto it = ticketInfo_.find(ticketId);
-                if (it == ticketInfo_.end()) {
-                    break;
-                }
-            }
-            json ticketDetails;
-            ticketDetails["cities"] = {flightDetails["departure_city"], flightDetails["destination_city"]};
-            ticketDetails["date"] = {flightDetails["week_day"], time};
-            ticketDetails["seatInfo"] = {planeId, seat, price};
-            ticketInfo_[ticketId] = ticketDetails;
-            userTickets_[username].push_back(ticketId);
-            return ticketId;
-        } else {
-            return "Seat is taken";
-        }
-    }
-
-    string ticketInfo(const string& ticketId, bool username) {
-        json ticketDetails = ticketInfo_[ticketId];
-        if (!ticketDetails.is_null()) {
-            string result;
-            if (username) {
-                for (const auto& userTickets : userTickets_.items()) {
-                    if (find(userTickets.value().begin(), userTickets.value().end(), ticketId) != userTickets.value().end()) {
-                        result += "Information about ticket " + ticketId + ", bought by " + userTickets.key() + ":\n";
-                    }
-                }
-            } else {
-                result += "Information about ticket " + ticketId + ":\n";
-            }
-            result += "Route: " + ticketDetails["cities"][0].get<string>() + " - " + ticketDetails["cities"][1].get<string>() + ";\n";
-            result += "Date: " + ticketDetails["date"][0].get<string>() + ", " + ticketDetails["date"][1].get<string>() + ";\n";
-            result += "Seat Info: PlaneId - " + ticketDetails["seatInfo"][0].get<string>() + ", Place - " + ticketDetails["seatInfo"][1].get<string>() + ", Price - " + to_string(ticketDetails["seatInfo"][2].get<int>()) + "$.";
-            return result;
-        } else {
-            return "Ticket not found";
-        }
-    }
-
-    string userTickets(const string& username) {
-        json ticketIds = userTickets_[username];
-        if (!ticketIds.is_null()) {
-            string result = "Tickets bought by " + username + ":\n\n";
-            int ticketCount = ticketIds.size();
-            int currentTicket = 1;
-            for (const auto& ticketId : ticketIds) {
-                result += ticketInfo(ticketId.get<string>(), false) + "\n";
-                if (currentTicket < ticketCount) {
-                    result += "\n";
-                }
-                currentTicket++;
-            }
-            return result;
-        } else {
-            return "No tickets found for the user";
-        }
-    }
-
-    string refund(const string& ticketId) {
-        if (ticketInfo_.find(ticketId) != ticketInfo_.end()) {
-            string zone;
-            json ticketDetails = ticketInfo_[ticketId];
-            string planeId = ticketDetails["seatInfo"][0].get<string>();
-            string seat = ticketDetails["seatInfo"][1].get<string>();
-            string price = to_string(ticketDetails["seatInfo"][2].get<int>());
-            for (const auto& zoneSeats : seatsByZone_.items()) {
-                if (find(zoneSeats.value().begin(), zoneSeats.value().end(), seat) != zoneSeats.value().end()) {
-                    zone = zoneSeats.key();
-                    zoneSeats.value().erase(find(zoneSeats.value().begin(), zoneSeats.value().end(), seat));
-                }
-            }
-            airplane_.refundUpdateFile(planeId, zone, seat);
-            ticketInfo_.erase(ticketId);
-            string username;
-            for (const auto& userTickets : userTickets_.items()) {
-                if (find(userTickets.value().begin(), userTickets.value().end(), ticketId) != userTickets.value().end()) {
-                    username = userTickets.key();
-                    userTickets.value().erase(find(userTickets.value().begin(), userTickets.value().end(), ticketId));
-                    if (userTickets.value().empty()) {
-                        userTickets_.erase(username);
-                    }
-                    break;
-                }
-            }
-            return "Confirmed refund of " + price + "$ for " + username;
-        } else {
-            return "Ticket not found";
-        }
-    }
-private:
-    FlightSchedule flightSchedule_;
-    Airplane airplane_;
-    json ticketInfo_;
-    json userTickets_;
-    json seatsByZone_;
-};
+#include "booking.h"
 
 enum Commands {
     Planes = 1,
@@ -262,22 +7,58 @@ enum Commands {
     Refund = 4,
     TicketInfo = 5,
     UserTickets = 6,
-    Stop = 7
+    Stop = 7,
+    CheapestFares = 8,
+    Availability = 9,
+    BookBestSeat = 10,
+    BookGroup = 11,
+    HoldSeat = 12,
+    ConfirmHold = 13,
+    Waitlist = 14,
+    WaitlistCapacity = 15,
+    FreeSeatSearch = 16,
+    UserTicketsPage = 17,
+    BookItinerary = 18,
+    Manifest = 19,
+    UserTicketsByDate = 20
 };
 
-int main() {
+int main(int argc, char* argv[]) {
     FileHandler flightDataHandler(R"(C:\Users\Admin\CLionProjects\first-oop-project\flightData.json)");
     FileHandler planeDataHandler(R"(C:\Users\Admin\CLionProjects\first-oop-project\planeData.json)");
+    string ledgerPath = R"(C:\Users\Admin\CLionProjects\first-oop-project\bookingLedger.bin)";
     FlightSchedule flightSchedule(flightDataHandler);
     Airplane airplane(planeDataHandler);
-    Ticket ticket(flightSchedule, airplane);
+    for (const string& error : airplane.loadErrors()) {
+        cout << error << endl;
+    }
+    LedgerReplay replay(flightSchedule, airplane);
+    if (argc > 1 && string(argv[1]) == "--replay") {
+        if (!replay.run(argc > 2 ? argv[2] : ledgerPath, cout)) {
+            cout << "Ledger not found" << endl;
+            return 1;
+        }
+        return 0;
+    }
+    if (replay.load(ledgerPath) && replay.corrupt()) {
+        cout << "Ledger is corrupt at byte " << replay.validBytes() << endl;
+        return 1;
+    }
+    AvailabilityHeatmap heatmap(flightSchedule, airplane);
+    BookingLedger ledger(ledgerPath, replay.validBytes());
+    Ticket ticket(flightSchedule, airplane, heatmap, ledger, replay);
+    FareSearch fareSearch(flightSchedule, airplane);
     int command;
-    string city1, city2, planeId, time, seat, username, Id;
+    size_t count, pageSize;
+    string cursor, nextCursor, page, requestKey, weekDay, lastWeekDay, lastTime;
+    int groupSize, ttlSeconds, fare, capacity, minFreeSeats;
+    string city1, city2, planeId, time, seat, username, Id, zone, preference;
     cout << "\n--Welcome to the Osta transportation company!--\n" << endl;
     while (true) {
-        cout << "1-Planes/2-Seats/3-Book seat/4-Refund/5-Ticket info/6-User tickets/7-Stop the program:" << endl;
+        cout << "1-Planes/2-Seats/3-Book seat/4-Refund/5-Ticket info/6-User tickets/7-Stop the program/8-Cheapest fares/9-Availability/10-Book best seat/11-Book group/12-Hold seat/13-Confirm hold/14-Waitlist/15-Waitlist capacity/16-Planes with free seats/17-User tickets page/18-Book itinerary/19-Manifest/20-User tickets by date:" << endl;
         cin >> command;
         cin.ignore();
+        ticket.expireHolds();
         if (command == Planes) {
             cout << "Available cities: Kyiv, Warsaw, Istanbul, Milan, Frankfurt" << endl;
             cout << "Enter departure city: " << endl;
@@ -302,7 +83,9 @@ int main() {
             getline(cin, seat);
             cout << "Enter username:" << endl;
             getline(cin, username);
-            string ticketId = ticket.bookSeat(planeId, time, seat, username);
+            cout << "Enter request key (optional):" << endl;
+            getline(cin, requestKey);
+            string ticketId = ticket.bookSeat(planeId, time, seat, username, requestKey);
             cout << "TicketId: " << ticketId << endl;
         } else if (command == Refund) {
             cout << "Enter Ticket ID:" << endl;
@@ -317,8 +100,153 @@ int main() {
         } else if (command == UserTickets) {
             cout << "Enter username:" << endl;
             getline(cin, username);
-            string userTicketsDetails = ticket.userTickets(username);
-            cout << userTicketsDetails << endl;
+            if (!ticket.streamUserTickets(username, cout)) {
+                cout << "No tickets found for the user";
+            }
+            cout << endl;
+        } else if (command == CheapestFares) {
+            cout << "Enter departure city: " << endl;
+            getline(cin, city1);
+            cout << "Enter destination city: " << endl;
+            getline(cin, city2);
+            cout << "Enter number of fares:" << endl;
+            cin >> count;
+            cin.ignore();
+            json fares = fareSearch.cheapestFlights(city1, city2, count);
+            cout << "Cheapest fares between " << city1 << " and " << city2 << ": " << fares << endl;
+        } else if (command == Availability) {
+            json freeSeats = heatmap.freeSeatsByDay();
+            cout << "Free seats by route and day:" << freeSeats << endl;
+        } else if (command == BookBestSeat) {
+            cout << "Enter planeId:" << endl;
+            getline(cin, planeId);
+            cout << "Enter time:" << endl;
+            getline(cin, time);
+            cout << "Enter zone (front/center/back):" << endl;
+            getline(cin, zone);
+            cout << "Enter seat preference (window/aisle/any):" << endl;
+            getline(cin, preference);
+            cout << "Enter username:" << endl;
+            getline(cin, username);
+            SeatPreference seatPreference = preference == "window" ? WindowSeat : preference == "aisle" ? AisleSeat : AnySeat;
+            string ticketId = ticket.bookBestSeat(planeId, time, zone, seatPreference, username);
+            cout << "TicketId: " << ticketId << endl;
+        } else if (command == BookGroup) {
+            cout << "Enter planeId:" << endl;
+            getline(cin, planeId);
+            cout << "Enter time:" << endl;
+            getline(cin, time);
+            cout << "Enter zone (front/center/back/any):" << endl;
+            getline(cin, zone);
+            cout << "Enter number of seats:" << endl;
+            cin >> groupSize;
+            cin.ignore();
+            cout << "Enter username:" << endl;
+            getline(cin, username);
+            string ticketIds = ticket.bookGroup(planeId, time, zone, groupSize, username);
+            cout << "TicketIds: " << ticketIds << endl;
+        } else if (command == HoldSeat) {
+            cout << "Enter planeId:" << endl;
+            getline(cin, planeId);
+            cout << "Enter time:" << endl;
+            getline(cin, time);
+            cout << "Enter seat:" << endl;
+            getline(cin, seat);
+            cout << "Enter username:" << endl;
+            getline(cin, username);
+            cout << "Enter hold time in seconds:" << endl;
+            cin >> ttlSeconds;
+            cin.ignore();
+            string holdId = ticket.holdSeat(planeId, time, seat, username, ttlSeconds);
+            cout << "HoldId: " << holdId << endl;
+        } else if (command == ConfirmHold) {
+            cout << "Enter Hold ID:" << endl;
+            getline(cin, Id);
+            string ticketId = ticket.confirmHold(Id);
+            cout << "TicketId: " << ticketId << endl;
+        } else if (command == Waitlist) {
+            cout << "Enter planeId:" << endl;
+            getline(cin, planeId);
+            cout << "Enter time:" << endl;
+            getline(cin, time);
+            cout << "Enter zone (front/center/back):" << endl;
+            getline(cin, zone);
+            cout << "Enter fare:" << endl;
+            cin >> fare;
+            cin.ignore();
+            cout << "Enter username:" << endl;
+            getline(cin, username);
+            string result = ticket.joinWaitlist(planeId, time, zone, fare, username);
+            cout << "Waitlist: " << result << endl;
+        } else if (command == WaitlistCapacity) {
+            cout << "Enter planeId:" << endl;
+            getline(cin, planeId);
+            cout << "Enter time:" << endl;
+            getline(cin, time);
+            cout << "Enter waitlist capacity:" << endl;
+            cin >> capacity;
+            cin.ignore();
+            ticket.setWaitlistCapacity(planeId, time, capacity);
+            cout << "Waitlist capacity for " << planeId << " at " << time << " set to " << capacity << endl;
+        } else if (command == FreeSeatSearch) {
+            cout << "Enter zone (front/center/back):" << endl;
+            getline(cin, zone);
+            cout << "Enter minimum free seats:" << endl;
+            cin >> minFreeSeats;
+            cin.ignore();
+            json planes = airplane.planesWithFreeSeats(zone, minFreeSeats);
+            cout << "Planes with at least " << minFreeSeats << " free seats in " << zone << ": " << planes << endl;
+        } else if (command == UserTicketsPage) {
+            cout << "Enter username:" << endl;
+            getline(cin, username);
+            cout << "Enter cursor (empty for the first page):" << endl;
+            getline(cin, cursor);
+            cout << "Enter page size:" << endl;
+            cin >> pageSize;
+            cin.ignore();
+            page.clear();
+            if (ticket.writeUserTicketsPage(username, cursor, pageSize, page, nextCursor)) {
+                cout << page << (nextCursor.empty() ? "End of tickets" : "Next cursor: " + nextCursor) << endl;
+            } else {
+                cout << "No tickets found for the user" << endl;
+            }
+        } else if (command == BookItinerary) {
+            cout << "Enter number of segments:" << endl;
+            cin >> count;
+            cin.ignore();
+            vector<ItinerarySegment> segments(count);
+            for (ItinerarySegment& segment : segments) {
+                cout << "Enter planeId:" << endl;
+                getline(cin, segment.planeId);
+                cout << "Enter time:" << endl;
+                getline(cin, segment.time);
+                cout << "Enter seat:" << endl;
+                getline(cin, segment.seat);
+            }
+            cout << "Enter username:" << endl;
+            getline(cin, username);
+            string ticketIds = ticket.bookItinerary(segments, username);
+            cout << "TicketIds: " << ticketIds << endl;
+        } else if (command == Manifest) {
+            cout << "Enter planeId:" << endl;
+            getline(cin, planeId);
+            cout << "Enter week day:" << endl;
+            getline(cin, weekDay);
+            cout << "Enter time:" << endl;
+            getline(cin, time);
+            cout << ticket.manifest(planeId, weekDay, time) << endl;
+        } else if (command == UserTicketsByDate) {
+            cout << "Enter username:" << endl;
+            getline(cin, username);
+            cout << "Enter first week day:" << endl;
+            getline(cin, weekDay);
+            cout << "Enter first time:" << endl;
+            getline(cin, time);
+            cout << "Enter last week day:" << endl;
+            getline(cin, lastWeekDay);
+            cout << "Enter last time:" << endl;
+            getline(cin, lastTime);
+            cout << ticket.userTicketsBetween(username, weekDay, time, lastWeekDay, lastTime) << endl;
         } else if (command == Stop) {
             cout << "Program stopped" << endl;
             break;